@@ -12,10 +12,32 @@ constexpr real_t Epsilon =
 
 constexpr index_t PhysicsIterations = 10;
 
+// how close speculative contacts let objects get, shapes that exactly touch are neither separated nor overlapping
+constexpr real_t SpeculativeSlop = 1.0E-3f;
+
+// split impulse, the share of the overlap past 'PenetrationSlop' pushed out per step
+constexpr index_t PositionIterations = 4;
+constexpr real_t PositionCorrection = 0.8f;
+constexpr real_t PenetrationSlop = 1.0E-3f;
+
+// slower impacts don't bounce
+constexpr real_t RestitutionThreshold = 1.0f;
+
 template Space2D;
 template Space3D;
+template SweepSpace2D;
+template SweepSpace3D;
+template TreeSpace2D;
+template TreeSpace3D;
+template batchers::DynamicTree2D;
+template batchers::DynamicTree3D;
+template HashGridSpace2D;
+template LBVHSpace3D;
+template OctreeSpace3D;
 template Object2D;
 template Object3D;
+template solvers::WideContacts2D;
+template solvers::WideContacts3D;
 
 enum class CollisionType
 {
@@ -74,7 +96,7 @@ inline static Rect calculate_bounding_box( const Rect &rect ) {
 }
 
 inline static Rect calculate_bounding_box( const Triangle &triangle ) {
-	const Vector2 base_extent = triangle.head_extent.normalized().tangent();
+	const Vector2 base_extent = triangle.head_extent.normalized().tangent() * (triangle.base_size * real_t( 0.5 ));
 	return {
 		std::min( { base_extent.x, -base_extent.x, triangle.head_extent.x } ) + triangle.base.x,
 		std::min( { base_extent.y, -base_extent.y, triangle.head_extent.y } ) + triangle.base.y,
@@ -101,6 +123,79 @@ inline static Rect calculate_bounding_box( const Ray2D &ray ) {
 	};
 }
 
+inline static Rect calculate_bounding_box( const Capsule2D &capsule ) {
+	return {
+		std::min( capsule.start.x, capsule.end.x ) - capsule.radius, std::min( capsule.start.y, capsule.end.y ) - capsule.radius,
+		std::max( capsule.start.x, capsule.end.x ) + capsule.radius, std::max( capsule.start.y, capsule.end.y ) + capsule.radius
+	};
+}
+
+inline static AABB calculate_bounding_box( const AABB &box ) {
+	return box;
+}
+
+inline static AABB calculate_bounding_box( const Sphere &sphere ) {
+	return {
+		sphere.center.x - sphere.radius, sphere.center.y - sphere.radius, sphere.center.z - sphere.radius,
+		sphere.center.x + sphere.radius, sphere.center.y + sphere.radius, sphere.center.z + sphere.radius
+	};
+}
+
+inline static AABB calculate_bounding_box( const Pyramid &pyramid ) {
+	const Vector3 low{ pyramid.support( { -1, 0, 0 } ).x, pyramid.support( { 0, -1, 0 } ).y, pyramid.support( { 0, 0, -1 } ).z };
+	const Vector3 high{ pyramid.support( { 1, 0, 0 } ).x, pyramid.support( { 0, 1, 0 } ).y, pyramid.support( { 0, 0, 1 } ).z };
+	return { low, high };
+}
+
+inline static AABB calculate_bounding_box( const Plane &plane ) {
+	Vector3 side, forward;
+	plane.get_axes( side, forward );
+	const Vector3 half_side = side * (plane.size.x * real_t( 0.5 ));
+	const Vector3 half_forward = forward * (plane.size.y * real_t( 0.5 ));
+
+	AABB box{ plane.origin + half_side + half_forward, plane.origin + half_side + half_forward };
+	box.encase( plane.origin + half_side - half_forward );
+	box.encase( plane.origin - half_side + half_forward );
+	box.encase( plane.origin - half_side - half_forward );
+	return box;
+}
+
+inline static AABB calculate_bounding_box( const Ray3D &ray ) {
+	return {
+		std::min<real_t>( 0, ray.extent.x ) + ray.origin.x,
+		std::min<real_t>( 0, ray.extent.y ) + ray.origin.y,
+		std::min<real_t>( 0, ray.extent.z ) + ray.origin.z,
+		std::max<real_t>( 0, ray.extent.x ) + ray.origin.x,
+		std::max<real_t>( 0, ray.extent.y ) + ray.origin.y,
+		std::max<real_t>( 0, ray.extent.z ) + ray.origin.z
+	};
+}
+
+inline static AABB calculate_bounding_box( const Capsule3D &capsule ) {
+	return {
+		std::min( capsule.start.x, capsule.end.x ) - capsule.radius,
+		std::min( capsule.start.y, capsule.end.y ) - capsule.radius,
+		std::min( capsule.start.z, capsule.end.z ) - capsule.radius,
+		std::max( capsule.start.x, capsule.end.x ) + capsule.radius,
+		std::max( capsule.start.y, capsule.end.y ) + capsule.radius,
+		std::max( capsule.start.z, capsule.end.z ) + capsule.radius
+	};
+}
+
+// 'TPolygon::recalculate' only handles 2D windings, the bounds are taken straight from the points
+inline static AABB calculate_bounding_box( const Polygon3D &polygon ) {
+	const std::vector<Vector3> &points = polygon.get_points();
+	if (points.empty())
+		return {};
+
+	AABB box{ points[ 0 ], points[ 0 ] };
+	for (const Vector3 &point : points)
+	{
+		box.encase( point );
+	}
+	return box;
+}
+
 // author: ??? (heavily modified by me)
 inline static bool is_clockwise( const Vector2 *const points, const size_t count ) {
 	real_t turn_factor{};
@@ -129,387 +224,6248 @@ namespace pphy
 	{
 		static constexpr size_t BatchResultInitCapacity = 1u << 8;
 		static constexpr size_t ObjectBatchInitCapacity = 1u << 8;
+		// below this many items a parallel build isn't worth the threads
+		static constexpr size_t ParallelMinimumCount = 1u << 10;
 
-		template<typename _OBJ>
-		TBoundsBatcher<_OBJ>::TBoundsBatcher() : m_results{} {
-			m_results.reserve( BatchResultInitCapacity );
-			for (ObjectBatch &batch : m_results)
+		// items per chunk when 'count' items are split over the pool, all of them when it runs on the calling thread
+		inline static size_t parallel_chunk( const size_t count, const IThreadPool *pool ) {
+			if (pool == nullptr || pool->get_concurrency() <= 1 || count < ParallelMinimumCount)
+				return std::max( count, size_t( 1 ) );
+
+			const size_t concurrency = pool->get_concurrency();
+			return (count + concurrency - 1) / concurrency;
+		}
+
+		// number of chunks 'count' items are split into, never zero so the per chunk buffers always exist
+		inline static size_t parallel_chunk_count( const size_t count, const size_t chunk ) {
+			return std::max( (count + chunk - 1) / chunk, size_t( 1 ) );
+		}
+
+		// splits [0, count) into 'parallel_chunk' sized ranges and runs 'proc( begin, end )' for each on the pool
+		// chunk 'i' always starts at 'i * parallel_chunk( count, pool )', so per chunk output can be merged in order
+		template <typename _PROC>
+		static void parallel_for( const size_t count, IThreadPool *pool, _PROC &&proc ) {
+			const size_t chunk = parallel_chunk( count, pool );
+			if (chunk >= count)
 			{
-				batch.reserve( ObjectBatchInitCapacity );
+				proc( size_t( 0 ), count );
+				return;
 			}
+
+			pool->dispatch(
+				parallel_chunk_count( count, chunk ),
+				[ &proc, chunk, count ]( const size_t task ) {
+					proc( task * chunk, std::min( task * chunk + chunk, count ) );
+				}
+			);
+		}
+
+		// statics live in the space's static tree, the batchers only ever see active dynamic objects
+		template <typename _OBJ>
+		inline static bool is_batched( const _OBJ &object ) {
+			return object.is_activated() && object.get_type() != ObjectType::Static;
 		}
 
+		void IslandBuilder::reset( size_t object_count ) {
+			m_parents.resize( object_count );
+			m_sizes.assign( object_count, 1 );
+			m_touched.assign( object_count, 0 );
+			m_attachments.clear();
 
-		template<typename _OBJ>
-		void TBoundsBatcher<_OBJ>::invalidate() {
-			m_dirty = true;
+			for (index_t i = 0; i < object_count; i++)
+			{
+				m_parents[ i ] = i;
+			}
 		}
 
-		template<typename _OBJ>
-		void TBoundsBatcher<_OBJ>::rebuild( const std::vector<object_type> &objects ) {
-			m_dirty = false;
+		index_t IslandBuilder::find( index_t index ) {
+			// path halving
+			while (m_parents[ index ] != index)
+			{
+				m_parents[ index ] = m_parents[ m_parents[ index ] ];
+				index = m_parents[ index ];
+			}
+			return index;
+		}
 
-			m_results.clear();
+		void IslandBuilder::link( index_t a, index_t b ) {
+			m_touched[ a ] = 1;
+			m_touched[ b ] = 1;
 
-			frame_type *const frames = new frame_type[ objects.size() ];
-			frame_type *const group_frames = new frame_type[ objects.size() ];
+			index_t root_a = find( a );
+			index_t root_b = find( b );
+			if (root_a == root_b)
+				return;
 
-			for (index_t i = 0; i < objects.size(); i++)
-			{
-				const object_type &obj = objects[ i ];
+			// union by size
+			if (m_sizes[ root_a ] < m_sizes[ root_b ])
+				std::swap( root_a, root_b );
 
-				// no need
-				if (!obj.is_activated())
-					continue;
+			m_parents[ root_b ] = root_a;
+			m_sizes[ root_a ] += m_sizes[ root_b ];
+		}
+
+		void IslandBuilder::attach( index_t fixed, index_t body ) {
+			m_touched[ body ] = 1;
+			m_attachments.emplace_back( fixed, body );
+		}
 
-				//if (obj.is_frame_dirty())
-				//	obj.recalculate_frame();
+		void IslandBuilder::build( BatchResult &islands ) {
+			const size_t object_count = m_parents.size();
+			m_lookup.assign( object_count, NoIsland );
 
-				//?? msvc++ be like 'BufFeR OveRruN wHilE WRiTinG tO 'frames'.'
-				frames[ i ] = obj.get_frame().expanded( m_expand_margin );
+			// numbers the islands in the order their first members come
+			m_roots.clear();
+			for (index_t i = 0; i < object_count; i++)
+			{
+				if (!m_touched[ i ])
+					continue;
 
-				bool found_group = false;
-				// single object's aabb can intersect multiple group frames
-				for (index_t group_index = 0; group_index < m_results.size(); group_index++)
+				const index_t root = find( i );
+				if (m_lookup[ root ] == NoIsland)
 				{
-					if (frames[ i ].intersects( group_frames[ group_index ] ))
-					{
-						group_frames[ group_index ].encase( frames[ i ] );
-						m_results[ group_index ].push_back( i );
-						found_group = true;
-					}
+					m_lookup[ root ] = m_roots.size();
+					m_roots.push_back( root );
 				}
+			}
+			const size_t island_count = m_roots.size();
 
-				if (!found_group)
-				{
-					m_results.emplace_back();
-					m_results.back().push_back( i );
-					group_frames[ m_results.size() - 1 ] = frames[ i ];
+			// a fixed object touching several bodies of one island joins it once
+			for (ObjectPair &attachment : m_attachments)
+			{
+				attachment.second = m_lookup[ find( attachment.second ) ];
+			}
+
+			std::sort(
+				m_attachments.begin(), m_attachments.end(),
+				[]( const ObjectPair &left, const ObjectPair &right ) {
+					return left.second < right.second || (left.second == right.second && left.first < right.first);
+				}
+			);
+			m_attachments.erase( std::unique( m_attachments.begin(), m_attachments.end() ), m_attachments.end() );
+
+			// the islands' sizes are known before anything is written, so every island goes straight into its final batch
+			m_counts.resize( island_count );
+			m_order.resize( island_count );
+			for (index_t island = 0; island < island_count; island++)
+			{
+				m_counts[ island ] = m_sizes[ m_roots[ island ] ];
+				m_order[ island ] = island;
+			}
+			for (const ObjectPair &attachment : m_attachments)
+			{
+				m_counts[ attachment.second ]++;
+			}
+
+			// biggest islands first so they get scheduled first, ties keep index order to stay deterministic
+			std::sort(
+				m_order.begin(), m_order.end(),
+				[ this ]( const index_t left, const index_t right ) {
+					return m_counts[ left ] > m_counts[ right ] || (m_counts[ left ] == m_counts[ right ] && left < right);
 				}
+			);
+
+			for (index_t island = 0; island < island_count; island++)
+			{
+				m_lookup[ m_roots[ m_order[ island ] ] ] = island;
+			}
+
+			// the batches past the count keep their storage for the steps that need more islands
+			while (islands.size() > island_count)
+			{
+				m_spare.push_back( std::move( islands.back() ) );
+				islands.pop_back();
+			}
+			while (islands.size() < island_count && !m_spare.empty())
+			{
+				islands.push_back( std::move( m_spare.back() ) );
+				m_spare.pop_back();
+			}
+			islands.resize( island_count );
+
+			// a batch keeps its place in the size order, so it already fits an island as big as last step's
+			for (index_t island = 0; island < island_count; island++)
+			{
+				islands[ island ].clear();
+			}
 
+			for (index_t i = 0; i < object_count; i++)
+			{
+				if (m_touched[ i ])
+					islands[ m_lookup[ find( i ) ] ].push_back( i );
 			}
 
-			delete[] frames;
-			delete[] group_frames;
+			for (const ObjectPair &attachment : m_attachments)
+			{
+				islands[ m_lookup[ m_roots[ attachment.second ] ] ].push_back( attachment.first );
+			}
 		}
-	}
 
-#pragma region(Solvers: Tearing my hear out)
-	namespace solvers
-	{
-		using I2D = Iterative2D;
-		//using I3D = Iterative3D;
+		LayerBuckets::LayerBuckets() {
+			m_matrix.fill( ~CollisionMask() );
+		}
 
+		void LayerBuckets::set_matrix( const LayerMatrix &matrix ) {
+			m_matrix = matrix;
+			for (index_t bucket = 0; bucket < m_masks.size(); bucket++)
+			{
+				m_reaches[ bucket ] = get_reach( m_masks[ bucket ] );
+			}
+		}
 
+		index_t LayerBuckets::find( CollisionMask mask ) {
+			// a scene uses a handful of masks, a scan beats a map
+			for (index_t bucket = 0; bucket < m_masks.size(); bucket++)
+			{
+				if (m_masks[ bucket ] == mask)
+					return bucket;
+			}
 
-		static_assert(std::is_same_v<ShapeType2D, I2D::shape_type_enum>, "expects I2D::shape_type_enum to be the same as ShapeType2D");
+			m_masks.push_back( mask );
+			m_reaches.push_back( get_reach( mask ) );
+			return m_masks.size() - 1;
+		}
 
-		template<typename ShapeType2D ShapeTypeA, typename ShapeType2D ShapeTypeB>
-		struct Iterative2DImpl
-		{
-			inline static bool process( I2D::object_ref_pair objects, I2D::shape_ref_pair shapes ) = delete;
-		};
+		index_t LayerBuckets::assign( index_t index, CollisionMask mask ) {
+			if (index >= m_objects.size())
+				m_objects.resize( index + 1, NullBucket );
 
-		template<>
-		struct Iterative2DImpl<ShapeType2D::Circle, ShapeType2D::Circle>
-		{
-			inline static bool process( I2D::object_ref_pair objects, I2D::shape_ref_pair shapes ) {
-				const real_t d =
-					(shapes.first.get_circle().center + objects.first.get_position()).distance( shapes.second.get_circle().center + objects.second.get_position() );
+			const index_t previous = m_objects[ index ];
+			m_objects[ index ] = find( mask );
+			return previous;
+		}
 
-				if (d >= shapes.first.get_circle().radius + shapes.second.get_circle().radius)
-				{
-					return false;
-				}
+		void LayerBuckets::clear() {
+			m_objects.clear();
+		}
 
-				const Vector2 dir =
-					(shapes.first.get_circle().center + objects.first.get_position()).direction( shapes.second.get_circle().center + objects.second.get_position() );
-				const Vector2 push_amount = dir * (shapes.first.get_circle().radius + shapes.second.get_circle().radius - d);
+		inline CollisionMask LayerBuckets::get_reach( CollisionMask mask ) const {
+			CollisionMask reach = 0;
+			while (mask)
+			{
+				reach |= m_matrix[ simd::lowest_bit( mask ) ];
+				mask &= mask - 1u;
+			}
+			return reach;
+		}
+
+		template<typename _OBJ>
+		TPairCache<_OBJ>::TPairCache() : m_entries{}, m_merged{}, m_began{}, m_ended{} {
+			m_entries.reserve( ObjectBatchInitCapacity );
+			m_merged.reserve( ObjectBatchInitCapacity );
+		}
 
+		template<typename _OBJ>
+		void TPairCache<_OBJ>::update( const PairList &pairs ) {
+			m_merged.clear();
+			m_began.clear();
+			m_ended.clear();
 
-				switch (get_collision_type( objects.first, objects.second ))
+			// both lists are sorted, a linear merge finds the deltas
+			index_t cached = 0;
+			index_t current = 0;
+			while (cached < m_entries.size() && current < pairs.size())
+			{
+				Entry &entry = m_entries[ cached ];
+				if (entry.pair < pairs[ current ])
 				{
-				case CollisionType::StaticClipCollision:
-				case CollisionType::CharecterClipCollision:
-				case CollisionType::RigidClipCollision:
-				case CollisionType::SoftClipCollision:
-				case CollisionType::ClipClipCollision:
-				case CollisionType::ClipStaticCollision:
-				case CollisionType::ClipCharecterCollision:
-				case CollisionType::ClipRigidCollision:
-				case CollisionType::ClipSoftCollision:
-					{
-						// TODO: trigger clip
-					}
-					break;
-				case CollisionType::RigidStaticCollision:
-				case CollisionType::CharecterStaticCollision:
-				case CollisionType::StaticRigidCollision:
-				case CollisionType::StaticCharecterCollision:
-					{
-						if (objects.first.get_type() == ObjectType::Static)
-						{
-							// impulse object 2
-							objects.second.set_position( objects.first.get_position() + push_amount );
-						}
-						else
-						{
-							// impulse object 1
-							objects.first.set_position( objects.first.get_position() - push_amount );
-						}
-					}
-					break;
-				case CollisionType::RigidRigidCollision:
-				case CollisionType::RigidCharecterCollision:
-				case CollisionType::CharecterRigidCollision:
-				case CollisionType::CharecterCharecterCollision:
-					{
-						if (objects.second.get_type() == objects.first.get_type())
-						{
-							objects.first.set_position( objects.first.get_position() - push_amount / static_cast<real_t>(2) );
-							objects.second.set_position( objects.second.get_position() + push_amount / static_cast<real_t>(2) );
-							break;
-						}
-					}
-					break;
-				default:
-					break;
+					m_ended.push_back( entry.pair );
+					cached++;
 				}
+				else if (pairs[ current ] < entry.pair)
+				{
+					m_began.push_back( pairs[ current ] );
+					m_merged.push_back( { pairs[ current ], 1, {}, {} } );
+					current++;
+				}
+				else
+				{
+					// moved, the contacts keep their storage
+					m_merged.push_back( std::move( entry ) );
+					m_merged.back().frames++;
+					cached++;
+					current++;
+				}
+			}
 
+			for (; cached < m_entries.size(); cached++)
+			{
+				m_ended.push_back( m_entries[ cached ].pair );
+			}
 
-
-				return true;
+			for (; current < pairs.size(); current++)
+			{
+				m_began.push_back( pairs[ current ] );
+				m_merged.push_back( { pairs[ current ], 1, {}, {} } );
 			}
-		};
 
-		template<>
-		template<typename I2D::shape_type_enum ShapeTypeA, typename I2D::shape_type_enum ShapeTypeB>
-		inline bool I2D::solve( object_ref_pair objects, shape_ref_pair shapes ) {
-			return Iterative2DImpl<ShapeTypeA, ShapeTypeB>::process( objects, shapes );
+			std::swap( m_entries, m_merged );
 		}
-	}
-#pragma endregion
 
-	template<typename _VEC>
-	void TPolygon<_VEC>::recalculate() {
-		m_dirty = false;
-		if (m_points.size() < 3)
-		{
-			m_winding = Winding::None;
+		template<typename _OBJ>
+		void TPairCache<_OBJ>::clear() {
+			m_entries.clear();
+			m_began.clear();
+			m_ended.clear();
+		}
 
+		template<typename _OBJ>
+		TBoundsBatcher<_OBJ>::TBoundsBatcher() : m_results{}, m_group_tree{ 0 } {
+			m_results.reserve( BatchResultInitCapacity );
 		}
-		else
-		{
-			m_winding =
-				is_clockwise( m_points.data(), m_points.size() ) ? Winding::Clockwise : Winding::CounterClockwise;
+
+		template<typename _OBJ>
+		void TBoundsBatcher<_OBJ>::invalidate() {
+			m_dirty = true;
 		}
 
-		m_center = {};
+		template<typename _OBJ>
+		void TBoundsBatcher<_OBJ>::set_layer_matrix( const LayerMatrix &matrix ) {
+			// objects were grouped by the old matrix
+			m_buckets.set_matrix( matrix );
+			m_dirty = true;
+		}
 
-		if (m_points.empty())
-			return;
+		template<typename _OBJ>
+		void TBoundsBatcher<_OBJ>::add_object( index_t index, const object_type &object ) {
+			// the pending rebuild will pick it up
+			if (m_dirty || !is_batched( object ))
+				return;
 
-		m_bounds = { m_points[ 0 ], m_points[ 0 ] };
+			update_object( index, object );
+		}
 
+		template<typename _OBJ>
+		void TBoundsBatcher<_OBJ>::remove_object( index_t index ) {
+			const index_t group = get_group( index );
+			if (group == NoGroup)
+				return;
 
-		for (index_t i = 0; i < m_points.size(); i++)
-		{
-			m_center += m_points[ i ];
-			m_bounds.encase( m_points[ i ] );
-		}
-		m_center /= static_cast<real_t>(m_points.size());
+			pop_member( index );
+			m_groups[ index ] = NoGroup;
 
-	}
+			const ObjectBatch &batch = m_results[ group ];
+			if (batch.empty())
+			{
+				free_group( group );
+				return;
+			}
 
-	template<typename _STATE>
-	TObject<_STATE>::TObject( ObjectType type ) : m_type{ type }, m_shapes{}, m_frame{} {
+			// the rest may have fallen apart, sweeping only once enough members left spreads the sweep over the removals
+			if (++m_group_removals[ group ] >= batch.size())
+				split_group( group );
+		}
 
-	}
+		template<typename _OBJ>
+		bool TBoundsBatcher<_OBJ>::update_object( index_t index, const object_type &object ) {
+			if (get_group( index ) != NoGroup)
+			{
+				if (m_frames[ index ].contains( object.get_frame() ) && !m_buckets.is_stale( index, object.get_mask() ))
+					return false;
 
-	template<typename _STATE>
-	void TObject<_STATE>::set_position( const vector_type &value ) {
-		m_position = value;
-		wakeup();
-	}
+				remove_object( index );
+			}
 
-	template<typename _STATE>
-	void TObject<_STATE>::set_angle( real_t value ) {
-		m_angle = value;
-		wakeup();
-	}
+			m_buckets.assign( index, object.get_mask() );
+			insert( index, object.get_frame().expanded( m_expand_margin ) );
+			return true;
+		}
 
-	template<typename _STATE>
-	void TObject<_STATE>::set_angular_velocity( real_t value ) {
-		m_angular_velocity = value;
-		wakeup();
-	}
+		template<typename _OBJ>
+		void TBoundsBatcher<_OBJ>::mark_moved( index_t index ) {
+			if (index >= m_moved_flags.size())
+				m_moved_flags.resize( index + 1, 0 );
 
-	template<typename _STATE>
-	void TObject<_STATE>::set_linear_velocity( const vector_type &value ) {
-		m_linear_velocity = value;
-		wakeup();
-	}
+			if (m_moved_flags[ index ])
+				return;
 
-	template<typename _STATE>
-	void TObject<_STATE>::set_mask( const CollisionMask mask ) {
-		m_mask = mask;
-		wakeup();
-	}
+			m_moved_flags[ index ] = 1;
+			m_moved.push_back( index );
+		}
 
-	template<typename _STATE>
-	void TObject<_STATE>::set_shape( const shape_type &shape ) {
-		set_shape( shape, 0 );
-	}
+		template<typename _OBJ>
+		inline bool TBoundsBatcher<_OBJ>::needs_update( index_t index, const object_type &object ) const {
+			const bool grouped = get_group( index ) != NoGroup;
+			return object.is_frame_dirty() || grouped != is_batched( object ) || (grouped && m_buckets.is_stale( index, object.get_mask() ));
+		}
 
-	template<typename _STATE>
-	void TObject<_STATE>::set_shape( const shape_type &shape, index_t index ) {
-		m_shapes[ index ] = shape;
-		m_shapes[ index ].recalculate_bounding_box();
-		wakeup();
-	}
+		template<typename _OBJ>
+		void TBoundsBatcher<_OBJ>::try_rebuild( const std::vector<object_type> &objects ) {
+			if (m_dirty)
+			{
+				rebuild( objects );
+				return;
+			}
 
-	template<typename _STATE>
-	void TObject<_STATE>::add_shape( const shape_type &shape ) {
-		m_shapes.push_back( shape );
-		wakeup();
-	}
+			for (const index_t index : m_moved)
+			{
+				m_moved_flags[ index ] = 0;
 
-	template<typename _STATE>
-	void TObject<_STATE>::remove_shape( index_t index ) {
+				if (is_batched( objects[ index ] ))
+					update_object( index, objects[ index ] );
+				else
+					remove_object( index );
+			}
+			m_moved.clear();
+		}
+
+		template<typename _OBJ>
+		void TBoundsBatcher<_OBJ>::rebuild( const std::vector<object_type> &objects ) {
+			m_dirty = false;
+
+			// every object is regrouped anyway
+			for (const index_t index : m_moved)
+			{
+				m_moved_flags[ index ] = 0;
+			}
+			m_moved.clear();
+
+			m_results.clear();
+			m_group_frames.clear();
+			m_group_removals.clear();
+			m_group_runs.clear();
+			m_free_groups.clear();
+			m_group_tree.clear();
+
+			m_frames.resize( objects.size() );
+			m_positions.resize( objects.size() );
+			m_groups.assign( objects.size(), NoGroup );
+
+			m_order.clear();
+			for (index_t i = 0; i < objects.size(); i++)
+			{
+				const object_type &obj = objects[ i ];
+
+				// no need
+				if (!is_batched( obj ))
+					continue;
+
+				m_frames[ i ] = obj.get_frame().expanded( m_expand_margin );
+				m_buckets.assign( i, obj.get_mask() );
+				m_order.push_back( i );
+			}
+
+			std::sort(
+				m_order.begin(), m_order.end(),
+				[ this ]( const index_t a, const index_t b ) {
+					return m_frames[ a ].begin.x < m_frames[ b ].begin.x || (m_frames[ a ].begin.x == m_frames[ b ].begin.x && a < b);
+				}
+			);
+
+			// each chunk sweeps its own objects against everything after them, only reading shared state
+			const size_t chunk = parallel_chunk( m_order.size(), m_thread_pool );
+			m_chunk_pairs.resize( parallel_chunk_count( m_order.size(), chunk ) );
+			parallel_for(
+				m_order.size(), m_thread_pool,
+				[ this, chunk ]( const size_t begin, const size_t end ) {
+					PairList &pairs = m_chunk_pairs[ begin / chunk ];
+					pairs.clear();
+
+					for (size_t i = begin; i < end; i++)
+					{
+						const frame_type &frame_a = m_frames[ m_order[ i ] ];
+						const index_t bucket_a = m_buckets.get_bucket( m_order[ i ] );
+						for (size_t j = i + 1; j < m_order.size() && m_frames[ m_order[ j ] ].begin.x <= frame_a.end.x; j++)
+						{
+							if (m_buckets.meet( bucket_a, m_buckets.get_bucket( m_order[ j ] ) ) && frame_a.intersects( m_frames[ m_order[ j ] ] ))
+								pairs.emplace_back( m_order[ i ], m_order[ j ] );
+						}
+					}
+				}
+			);
+
+			m_islands.reset( objects.size() );
+			for (const PairList &pairs : m_chunk_pairs)
+			{
+				for (const ObjectPair &pair : pairs)
+				{
+					m_islands.link( pair.first, pair.second );
+				}
+			}
+
+			// groups are numbered in the order of their lowest member
+			m_hits.assign( objects.size(), NoGroup );
+			for (index_t i = 0; i < objects.size(); i++)
+			{
+				if (!is_batched( objects[ i ] ))
+					continue;
+
+				index_t &group = m_hits[ m_islands.find( i ) ];
+				if (group == NoGroup)
+					group = allocate_group( m_frames[ i ] );
+				else
+					m_group_frames[ group ].encase( m_frames[ i ] );
+
+				push_member( group, i );
+			}
+
+			for (index_t group = 0; group < m_results.size(); group++)
+			{
+				m_group_tree.insert( group, m_group_frames[ group ] );
+			}
+		}
+
+		template<typename _OBJ>
+		void TBoundsBatcher<_OBJ>::insert( index_t index, const frame_type &frame ) {
+			if (index >= m_groups.size())
+			{
+				m_groups.resize( index + 1, NoGroup );
+				m_positions.resize( index + 1 );
+				m_frames.resize( index + 1 );
+			}
+
+			m_frames[ index ] = frame;
+
+			// groups the object's layers never meet are left alone even when the frames touch
+			const index_t bucket = m_buckets.get_bucket( index );
+			m_hits.clear();
+			m_group_tree.query(
+				frame,
+				[ this, bucket ]( const index_t group ) {
+					if (group_meets( group, bucket ))
+						m_hits.push_back( group );
+					return true;
+				}
+			);
+
+			if (m_hits.empty())
+			{
+				const index_t group = allocate_group( frame );
+				push_member( group, index );
+				m_group_tree.insert( group, frame );
+				return;
+			}
+
+			// the object bridges every group it hits, the smaller ones move into the biggest
+			index_t keeper = m_hits[ 0 ];
+			for (const index_t group : m_hits)
+			{
+				if (m_results[ group ].size() > m_results[ keeper ].size())
+					keeper = group;
+			}
+
+			frame_type keeper_frame = m_group_frames[ keeper ].encasing( frame );
+			push_member( keeper, index );
+
+			for (const index_t group : m_hits)
+			{
+				if (group == keeper)
+					continue;
+
+				keeper_frame.encase( m_group_frames[ group ] );
+				m_group_removals[ keeper ] += m_group_removals[ group ];
+
+				for (const index_t member : m_results[ group ])
+				{
+					push_member( keeper, member );
+				}
+
+				free_group( group );
+			}
+
+			m_group_frames[ keeper ] = keeper_frame;
+			m_group_tree.move( keeper, keeper_frame );
+		}
+
+		// a group index with an empty batch, reusing freed ones first; the caller puts it in the tree
+		template<typename _OBJ>
+		index_t TBoundsBatcher<_OBJ>::allocate_group( const frame_type &frame ) {
+			if (m_free_groups.empty())
+			{
+				m_results.emplace_back();
+				m_group_frames.push_back( frame );
+				m_group_removals.push_back( 0 );
+				m_group_runs.emplace_back();
+				return m_results.size() - 1;
+			}
+
+			const index_t group = m_free_groups.back();
+			m_free_groups.pop_back();
+			m_group_frames[ group ] = frame;
+			m_group_removals[ group ] = 0;
+			return group;
+		}
+
+		// group indices are never compacted, renumbering the last group would touch all of its members
+		template<typename _OBJ>
+		void TBoundsBatcher<_OBJ>::free_group( index_t group ) {
+			m_group_tree.remove( group );
+			m_results[ group ].clear();
+			m_group_runs[ group ].clear();
+			m_free_groups.push_back( group );
+		}
+
+		template<typename _OBJ>
+		void TBoundsBatcher<_OBJ>::push_member( index_t group, index_t index ) {
+			ObjectBatch &batch = m_results[ group ];
+			std::vector<BucketRun> &runs = m_group_runs[ group ];
+			const index_t bucket = m_buckets.get_bucket( index );
+
+			index_t run = 0;
+			while (run < runs.size() && runs[ run ].bucket != bucket)
+				run++;
+
+			if (run == runs.size())
+				runs.push_back( { bucket, static_cast<index_t>(batch.size()), static_cast<index_t>(batch.size()) } );
+
+			// every later run hands its first member to its end, the hole moves down to the end of 'run'
+			index_t slot = batch.size();
+			batch.push_back( index );
+			for (index_t later = runs.size() - 1; later > run; later--)
+			{
+				BucketRun &current = runs[ later ];
+				batch[ slot ] = batch[ current.begin ];
+				m_positions[ batch[ slot ] ] = slot;
+				slot = current.begin++;
+				current.end++;
+			}
+
+			batch[ slot ] = index;
+			m_positions[ index ] = slot;
+			m_groups[ index ] = group;
+			runs[ run ].end++;
+		}
+
+		template<typename _OBJ>
+		void TBoundsBatcher<_OBJ>::pop_member( index_t index ) {
+			const index_t group = m_groups[ index ];
+			ObjectBatch &batch = m_results[ group ];
+			std::vector<BucketRun> &runs = m_group_runs[ group ];
+			const index_t position = m_positions[ index ];
+
+			index_t run = 0;
+			while (runs[ run ].end <= position)
+				run++;
+
+			// the last member of the run fills the hole, then every later run hands its last member to the slot before it
+			index_t slot = position;
+			for (index_t later = run; later < runs.size(); later++)
+			{
+				BucketRun &current = runs[ later ];
+				const index_t last = current.end - 1;
+				batch[ slot ] = batch[ last ];
+				m_positions[ batch[ slot ] ] = slot;
+				slot = last;
+
+				if (later != run)
+					current.begin--;
+				current.end--;
+			}
+			batch.pop_back();
+
+			if (runs[ run ].begin == runs[ run ].end)
+				runs.erase( runs.begin() + run );
+		}
+
+		template<typename _OBJ>
+		inline bool TBoundsBatcher<_OBJ>::group_meets( index_t group, index_t bucket ) const {
+			for (const BucketRun &run : m_group_runs[ group ])
+			{
+				if (m_buckets.meet( bucket, run.bucket ))
+					return true;
+			}
+			return false;
+		}
+
+		// regroups the members of 'group' by their own frames, only this group is touched
+		template<typename _OBJ>
+		void TBoundsBatcher<_OBJ>::split_group( index_t group ) {
+			const size_t count = m_results[ group ].size();
+
+			m_islands.reset( count );
+			m_hits.resize( count );
+			for (index_t i = 0; i < count; i++)
+			{
+				m_hits[ i ] = i;
+			}
+
+			{
+				const ObjectBatch &batch = m_results[ group ];
+
+				// local sweep on the x axis
+				std::sort(
+					m_hits.begin(), m_hits.end(),
+					[ this, &batch ]( const index_t a, const index_t b ) {
+						return m_frames[ batch[ a ] ].begin.x < m_frames[ batch[ b ] ].begin.x;
+					}
+				);
+
+				for (index_t i = 0; i < count; i++)
+				{
+					const frame_type &frame_a = m_frames[ batch[ m_hits[ i ] ] ];
+					for (index_t j = i + 1; j < count && m_frames[ batch[ m_hits[ j ] ] ].begin.x <= frame_a.end.x; j++)
+					{
+						if (!m_buckets.meet( m_buckets.get_bucket( batch[ m_hits[ i ] ] ), m_buckets.get_bucket( batch[ m_hits[ j ] ] ) ))
+							continue;
+
+						if (!frame_a.intersects( m_frames[ batch[ m_hits[ j ] ] ] ))
+							continue;
+
+						m_islands.link( m_hits[ i ], m_hits[ j ] );
+					}
+				}
+			}
+
+			// the component of the first member keeps the group, the others get new groups
+			m_components.assign( count, NoGroup );
+			m_components[ m_islands.find( 0 ) ] = group;
+			m_group_removals[ group ] = 0;
+
+			frame_type group_frame = m_frames[ m_results[ group ][ 0 ] ];
+
+			// every member is pushed again, so the runs of each component come out whole
+			m_order.assign( m_results[ group ].begin(), m_results[ group ].end() );
+			m_results[ group ].clear();
+			m_group_runs[ group ].clear();
+
+			for (index_t i = 0; i < count; i++)
+			{
+				const index_t member = m_order[ i ];
+				const index_t root = m_islands.find( i );
+
+				if (m_components[ root ] == NoGroup)
+					m_components[ root ] = allocate_group( m_frames[ member ] );
+
+				const index_t target = m_components[ root ];
+				push_member( target, member );
+
+				if (target == group)
+					group_frame.encase( m_frames[ member ] );
+				else
+					m_group_frames[ target ].encase( m_frames[ member ] );
+			}
+
+			// the frame only shrinks here, 'move' would keep the old one
+			m_group_frames[ group ] = group_frame;
+			m_group_tree.remove( group );
+			m_group_tree.insert( group, group_frame );
+
+			for (index_t i = 0; i < count; i++)
+			{
+				const index_t target = m_components[ i ];
+				if (target != NoGroup && target != group)
+					m_group_tree.insert( target, m_group_frames[ target ] );
+			}
+		}
+
+		template<typename _OBJ>
+		TSweepBatcher<_OBJ>::TSweepBatcher() : m_results{}, m_pairs{} {
+			m_results.reserve( BatchResultInitCapacity );
+			m_pairs.reserve( ObjectBatchInitCapacity );
+		}
+
+		template<typename _OBJ>
+		void TSweepBatcher<_OBJ>::invalidate() {
+			m_dirty = true;
+		}
+
+		template<typename _OBJ>
+		void TSweepBatcher<_OBJ>::sync_axis( const std::vector<object_type> &objects ) {
+			// objects are only ever appended, a shrinking list means the space was rebuilt
+			if (objects.size() < m_synced_count)
+			{
+				m_axes.clear();
+				m_buckets.clear();
+				m_synced_count = 0;
+			}
+
+			// statics never enter the axes, they're in the space's static tree for good
+			for (index_t i = m_synced_count; i < objects.size(); i++)
+			{
+				if (objects[ i ].get_type() != ObjectType::Static)
+					push_endpoint( i, objects[ i ].get_mask() );
+			}
+			m_synced_count = objects.size();
+
+			m_frames.resize( objects.size() );
+		}
+
+		template<typename _OBJ>
+		void TSweepBatcher<_OBJ>::push_endpoint( index_t index, CollisionMask mask ) {
+			m_buckets.assign( index, mask );
+
+			const index_t bucket = m_buckets.get_bucket( index );
+			if (bucket >= m_axes.size())
+			{
+				m_axes.resize( bucket + 1 );
+				m_sorted_frames.resize( bucket + 1 );
+			}
+
+			m_axes[ bucket ].push_back( { {}, index } );
+		}
+
+		template<typename _OBJ>
+		void TSweepBatcher<_OBJ>::sort_axis( std::vector<Endpoint> &axis ) {
+			// insertion sort, the order barely changes between frames so this is close to linear
+			for (index_t i = 1; i < axis.size(); i++)
+			{
+				const Endpoint current = axis[ i ];
+				index_t j = i;
+				for (; j > 0 && axis[ j - 1 ].value > current.value; j--)
+				{
+					axis[ j ] = axis[ j - 1 ];
+				}
+				axis[ j ] = current;
+			}
+		}
+
+		template<typename _OBJ>
+		void TSweepBatcher<_OBJ>::sweep( const std::vector<object_type> &objects, index_t a, index_t b ) {
+			const std::vector<Endpoint> &axis_a = m_axes[ a ];
+			const std::vector<Endpoint> &axis_b = m_axes[ b ];
+			const TFrameSoA<frame_type> &frames_b = m_sorted_frames[ b ];
+
+			for (index_t i = 0; i < axis_a.size(); i++)
+			{
+				const index_t index_a = axis_a[ i ].index;
+				if (!is_batched( objects[ index_a ] ))
+					continue;
+
+				const frame_type &frame_a = m_frames[ index_a ];
+
+				// within one axis every object looks ahead of itself; across two axes each object looks at the other
+				// axis' objects starting after it, ties are only looked at from 'a'
+				index_t first = i + 1;
+				if (a != b)
+				{
+					first = std::lower_bound(
+						axis_b.begin(), axis_b.end(), frame_a.begin.x,
+						[]( const Endpoint &endpoint, const value_type value ) {
+							return endpoint.value < value;
+						}
+					) - axis_b.begin();
+				}
+
+				// every object starting before 'frame_a' ends on the x axis is a candidate, a chunk starting
+				// past that can't hold any; lanes past the run or the list fail the overlap test on their own
+				for (index_t chunk = first; chunk < axis_b.size() && axis_b[ chunk ].value <= frame_a.end.x; chunk += simd::SimdWidth)
+				{
+					uint32_t mask = frames_b.overlap_mask( frame_a, chunk );
+					while (mask)
+					{
+						const index_t index_b = axis_b[ chunk + simd::lowest_bit( mask ) ].index;
+						mask &= mask - 1u;
+
+						m_pairs.emplace_back( std::min( index_a, index_b ), std::max( index_a, index_b ) );
+					}
+				}
+			}
+
+			if (a == b)
+				return;
+
+			// the other way around, strictly after so the ties found above aren't reported again
+			const TFrameSoA<frame_type> &frames_a = m_sorted_frames[ a ];
+			for (index_t i = 0; i < axis_b.size(); i++)
+			{
+				const index_t index_b = axis_b[ i ].index;
+				if (!is_batched( objects[ index_b ] ))
+					continue;
+
+				const frame_type &frame_b = m_frames[ index_b ];
+				const index_t first = std::upper_bound(
+					axis_a.begin(), axis_a.end(), frame_b.begin.x,
+					[]( const value_type value, const Endpoint &endpoint ) {
+						return value < endpoint.value;
+					}
+				) - axis_a.begin();
+
+				for (index_t chunk = first; chunk < axis_a.size() && axis_a[ chunk ].value <= frame_b.end.x; chunk += simd::SimdWidth)
+				{
+					uint32_t mask = frames_a.overlap_mask( frame_b, chunk );
+					while (mask)
+					{
+						const index_t index_a = axis_a[ chunk + simd::lowest_bit( mask ) ].index;
+						mask &= mask - 1u;
+
+						m_pairs.emplace_back( std::min( index_a, index_b ), std::max( index_a, index_b ) );
+					}
+				}
+			}
+		}
+
+		template<typename _OBJ>
+		void TSweepBatcher<_OBJ>::rebuild( const std::vector<object_type> &objects ) {
+			if (m_dirty)
+			{
+				m_dirty = false;
+				sync_axis( objects );
+			}
+
+			m_pairs.clear();
+
+			// objects whose mask changed move to their new bucket's axis, the sort below puts them in place
+			m_restaged.clear();
+			for (std::vector<Endpoint> &axis : m_axes)
+			{
+				for (index_t i = 0; i < axis.size();)
+				{
+					if (!m_buckets.is_stale( axis[ i ].index, objects[ axis[ i ].index ].get_mask() ))
+					{
+						i++;
+						continue;
+					}
+
+					m_restaged.push_back( axis[ i ].index );
+					axis.erase( axis.begin() + i );
+				}
+			}
+
+			for (const index_t index : m_restaged)
+			{
+				push_endpoint( index, objects[ index ].get_mask() );
+			}
+
+			for (index_t bucket = 0; bucket < m_axes.size(); bucket++)
+			{
+				std::vector<Endpoint> &axis = m_axes[ bucket ];
+				for (Endpoint &endpoint : axis)
+				{
+					m_frames[ endpoint.index ] = objects[ endpoint.index ].get_frame().expanded( m_expand_margin );
+					endpoint.value = m_frames[ endpoint.index ].begin.x;
+				}
+
+				sort_axis( axis );
+
+				TFrameSoA<frame_type> &sorted_frames = m_sorted_frames[ bucket ];
+				sorted_frames.resize( axis.size() );
+				for (index_t i = 0; i < axis.size(); i++)
+				{
+					if (is_batched( objects[ axis[ i ].index ] ))
+						sorted_frames.set( i, m_frames[ axis[ i ].index ] );
+					else
+						sorted_frames.set_empty( i );
+				}
+			}
+
+			// bucket pairs whose layers never meet are skipped whole
+			for (index_t a = 0; a < m_axes.size(); a++)
+			{
+				for (index_t b = a; b < m_axes.size(); b++)
+				{
+					if (m_buckets.meet( a, b ))
+						sweep( objects, a, b );
+				}
+			}
+
+			m_islands.reset( objects.size() );
+			for (const ObjectPair &pair : m_pairs)
+			{
+				m_islands.link( pair.first, pair.second );
+			}
+			m_islands.build( m_results );
+		}
+
+		template<typename _FRAME>
+		TDynamicTree<_FRAME>::TDynamicTree( value_type margin ) : m_nodes{}, m_leaves{}, m_margin{ margin } {
+			m_nodes.reserve( ObjectBatchInitCapacity );
+		}
+
+		template<typename _FRAME>
+		void TDynamicTree<_FRAME>::insert( index_t key, const frame_type &frame ) {
+			if (key >= m_leaves.size())
+				m_leaves.resize( key + 1, NullNode );
+
+			const index_t leaf = allocate_node();
+			m_nodes[ leaf ] = { frame.expanded( m_margin ), NullNode, NullNode, NullNode, key, 0 };
+			m_leaves[ key ] = leaf;
+			m_count++;
+
+			insert_leaf( leaf );
+		}
+
+		template<typename _FRAME>
+		bool TDynamicTree<_FRAME>::move( index_t key, const frame_type &frame ) {
+			const index_t leaf = m_leaves[ key ];
+			if (m_nodes[ leaf ].frame.contains( frame ))
+				return false;
+
+			remove_leaf( leaf );
+			m_nodes[ leaf ].frame = frame.expanded( m_margin );
+			insert_leaf( leaf );
+			return true;
+		}
+
+		template<typename _FRAME>
+		void TDynamicTree<_FRAME>::remove( index_t key ) {
+			const index_t leaf = m_leaves[ key ];
+			remove_leaf( leaf );
+			free_node( leaf );
+			m_leaves[ key ] = NullNode;
+			m_count--;
+		}
+
+		template<typename _FRAME>
+		void TDynamicTree<_FRAME>::clear() {
+			m_nodes.clear();
+			m_leaves.clear();
+			m_root = NullNode;
+			m_free_list = NullNode;
+			m_count = 0;
+		}
+
+		template<typename _FRAME>
+		void TDynamicTree<_FRAME>::query_pairs( PairList &pairs ) const {
+			for (const index_t leaf : m_leaves)
+			{
+				if (leaf == NullNode)
+					continue;
+
+				const index_t key = m_nodes[ leaf ].key;
+				query(
+					m_nodes[ leaf ].frame,
+					[ &pairs, key ]( const index_t other ) {
+						// both keys find each other, only the smaller one reports
+						if (key < other)
+							pairs.emplace_back( key, other );
+						return true;
+					}
+				);
+			}
+		}
+
+		template<typename _FRAME>
+		void TDynamicTree<_FRAME>::query_pairs( const TDynamicTree &other, PairList &pairs ) const {
+			for (const index_t leaf : m_leaves)
+			{
+				if (leaf == NullNode)
+					continue;
+
+				const index_t key = m_nodes[ leaf ].key;
+				other.query(
+					m_nodes[ leaf ].frame,
+					[ &pairs, key ]( const index_t other_key ) {
+						pairs.emplace_back( std::min( key, other_key ), std::max( key, other_key ) );
+						return true;
+					}
+				);
+			}
+		}
+
+		template<typename _FRAME>
+		index_t TDynamicTree<_FRAME>::allocate_node() {
+			if (m_free_list == NullNode)
+			{
+				m_nodes.emplace_back();
+				return m_nodes.size() - 1;
+			}
+
+			const index_t node = m_free_list;
+			m_free_list = m_nodes[ node ].parent;
+			return node;
+		}
+
+		template<typename _FRAME>
+		void TDynamicTree<_FRAME>::free_node( index_t node ) {
+			m_nodes[ node ].parent = m_free_list;
+			m_nodes[ node ].height = -1;
+			m_free_list = node;
+		}
+
+		template<typename _FRAME>
+		void TDynamicTree<_FRAME>::insert_leaf( index_t leaf ) {
+			if (m_root == NullNode)
+			{
+				m_root = leaf;
+				m_nodes[ leaf ].parent = NullNode;
+				return;
+			}
+
+			const frame_type leaf_frame = m_nodes[ leaf ].frame;
+
+			// descend to the sibling with the cheapest surface area increase
+			index_t index = m_root;
+			while (!is_leaf( index ))
+			{
+				const Node &node = m_nodes[ index ];
+				const value_type combined = node.frame.encasing( leaf_frame ).measure();
+
+				const value_type cost = 2 * combined;
+				const value_type inheritance_cost = 2 * (combined - node.frame.measure());
+
+				value_type child_costs[ 2 ];
+				const index_t children[ 2 ] = { node.left, node.right };
+				for (int i = 0; i < 2; i++)
+				{
+					const frame_type &child_frame = m_nodes[ children[ i ] ].frame;
+					child_costs[ i ] = child_frame.encasing( leaf_frame ).measure() + inheritance_cost;
+					if (!is_leaf( children[ i ] ))
+						child_costs[ i ] -= child_frame.measure();
+				}
+
+				if (cost < child_costs[ 0 ] && cost < child_costs[ 1 ])
+					break;
+
+				index = child_costs[ 0 ] < child_costs[ 1 ] ? children[ 0 ] : children[ 1 ];
+			}
+
+			const index_t sibling = index;
+			const index_t old_parent = m_nodes[ sibling ].parent;
+			const index_t new_parent = allocate_node();
+
+			m_nodes[ new_parent ] = {
+				leaf_frame.encasing( m_nodes[ sibling ].frame ), old_parent, sibling, leaf, NullNode, m_nodes[ sibling ].height + 1
+			};
+
+			if (old_parent != NullNode)
+			{
+				if (m_nodes[ old_parent ].left == sibling)
+					m_nodes[ old_parent ].left = new_parent;
+				else
+					m_nodes[ old_parent ].right = new_parent;
+			}
+			else
+			{
+				m_root = new_parent;
+			}
+
+			m_nodes[ sibling ].parent = new_parent;
+			m_nodes[ leaf ].parent = new_parent;
+
+			refit( new_parent );
+		}
+
+		template<typename _FRAME>
+		void TDynamicTree<_FRAME>::remove_leaf( index_t leaf ) {
+			if (leaf == m_root)
+			{
+				m_root = NullNode;
+				return;
+			}
+
+			const index_t parent = m_nodes[ leaf ].parent;
+			const index_t grand_parent = m_nodes[ parent ].parent;
+			const index_t sibling = m_nodes[ parent ].left == leaf ? m_nodes[ parent ].right : m_nodes[ parent ].left;
+
+			free_node( parent );
+
+			if (grand_parent == NullNode)
+			{
+				m_root = sibling;
+				m_nodes[ sibling ].parent = NullNode;
+				return;
+			}
+
+			if (m_nodes[ grand_parent ].left == parent)
+				m_nodes[ grand_parent ].left = sibling;
+			else
+				m_nodes[ grand_parent ].right = sibling;
+
+			m_nodes[ sibling ].parent = grand_parent;
+			refit( grand_parent );
+		}
+
+		template<typename _FRAME>
+		void TDynamicTree<_FRAME>::refit( index_t node ) {
+			while (node != NullNode)
+			{
+				node = balance( node );
+
+				Node &current = m_nodes[ node ];
+				const Node &left = m_nodes[ current.left ];
+				const Node &right = m_nodes[ current.right ];
+
+				current.height = 1 + std::max( left.height, right.height );
+				current.frame = left.frame.encasing( right.frame );
+
+				node = current.parent;
+			}
+		}
+
+		// AVL style rotation, returns the node now standing at 'node's place
+		template<typename _FRAME>
+		index_t TDynamicTree<_FRAME>::balance( index_t node ) {
+			Node &a = m_nodes[ node ];
+			if (is_leaf( node ) || a.height < 2)
+				return node;
+
+			const index_t index_b = a.left;
+			const index_t index_c = a.right;
+			Node &b = m_nodes[ index_b ];
+			Node &c = m_nodes[ index_c ];
+
+			const int32_t skew = c.height - b.height;
+
+			if (skew > 1 || skew < -1)
+			{
+				// 'up' is the taller child, it takes the place of 'a'
+				const bool right_heavy = skew > 1;
+				const index_t index_up = right_heavy ? index_c : index_b;
+				Node &up = right_heavy ? c : b;
+				const Node &other = right_heavy ? b : c;
+
+				const index_t index_f = up.left;
+				const index_t index_g = up.right;
+				Node &f = m_nodes[ index_f ];
+				Node &g = m_nodes[ index_g ];
+
+				up.left = node;
+				up.parent = a.parent;
+				a.parent = index_up;
+
+				if (up.parent != NullNode)
+				{
+					if (m_nodes[ up.parent ].left == node)
+						m_nodes[ up.parent ].left = index_up;
+					else
+						m_nodes[ up.parent ].right = index_up;
+				}
+				else
+				{
+					m_root = index_up;
+				}
+
+				// the taller grand child stays with 'up', the shorter one moves to 'a'
+				const bool keep_f = f.height > g.height;
+				const index_t index_kept = keep_f ? index_f : index_g;
+				const index_t index_moved = keep_f ? index_g : index_f;
+				Node &kept = keep_f ? f : g;
+				Node &moved = keep_f ? g : f;
+
+				up.right = index_kept;
+				if (right_heavy)
+					a.right = index_moved;
+				else
+					a.left = index_moved;
+				moved.parent = node;
+
+				a.frame = other.frame.encasing( moved.frame );
+				a.height = 1 + std::max( other.height, moved.height );
+				up.frame = a.frame.encasing( kept.frame );
+				up.height = 1 + std::max( a.height, kept.height );
+
+				return index_up;
+			}
+
+			return node;
+		}
+
+		template<typename _OBJ>
+		TTreeBatcher<_OBJ>::TTreeBatcher() : m_results{}, m_pairs{} {
+			m_results.reserve( BatchResultInitCapacity );
+			m_pairs.reserve( ObjectBatchInitCapacity );
+		}
+
+		template<typename _OBJ>
+		void TTreeBatcher<_OBJ>::invalidate() {
+			m_dirty = true;
+		}
+
+		template<typename _OBJ>
+		void TTreeBatcher<_OBJ>::set_layer_matrix( const LayerMatrix &matrix ) {
+			m_buckets.set_matrix( matrix );
+			m_changed = true;
+		}
+
+		template<typename _OBJ>
+		void TTreeBatcher<_OBJ>::add_object( index_t index, const object_type &object ) {
+			if (m_dirty || !is_batched( object ))
+				return;
+
+			insert( index, object );
+			m_changed = true;
+		}
+
+		template<typename _OBJ>
+		void TTreeBatcher<_OBJ>::insert( index_t index, const object_type &object ) {
+			m_buckets.assign( index, object.get_mask() );
+
+			const index_t bucket = m_buckets.get_bucket( index );
+			while (m_trees.size() <= bucket)
+				m_trees.emplace_back( m_expand_margin );
+
+			m_trees[ bucket ].insert( index, object.get_frame() );
+		}
+
+		template<typename _OBJ>
+		void TTreeBatcher<_OBJ>::rebuild( const std::vector<object_type> &objects ) {
+			bool changed = m_dirty || m_changed;
+			m_changed = false;
+			if (m_dirty)
+			{
+				m_dirty = false;
+				for (tree_type &tree : m_trees)
+				{
+					tree.clear();
+				}
+			}
+
+			for (index_t i = 0; i < objects.size(); i++)
+			{
+				const object_type &obj = objects[ i ];
+				const index_t bucket = m_buckets.get_bucket( i );
+				const bool in_tree = bucket != LayerBuckets::NullBucket && m_trees[ bucket ].contains( i );
+
+				// a new mask means a different tree
+				if (in_tree && (!is_batched( obj ) || m_buckets.is_stale( i, obj.get_mask() )))
+				{
+					m_trees[ bucket ].remove( i );
+					changed = true;
+				}
+
+				if (!is_batched( obj ))
+					continue;
+
+				if (!in_tree || m_buckets.is_stale( i, obj.get_mask() ))
+				{
+					insert( i, obj );
+					changed = true;
+					continue;
+				}
+
+				if (m_trees[ bucket ].move( i, obj.get_frame() ))
+					changed = true;
+			}
+
+			// fat frames are the same as last time, so are the pairs
+			if (!changed)
+				return;
+
+			m_pairs.clear();
+
+			// bucket pairs whose layers never meet are skipped whole, the smaller tree walks its leaves
+			for (index_t a = 0; a < m_trees.size(); a++)
+			{
+				if (m_buckets.meet( a, a ))
+					m_trees[ a ].query_pairs( m_pairs );
+
+				for (index_t b = a + 1; b < m_trees.size(); b++)
+				{
+					if (!m_buckets.meet( a, b ))
+						continue;
+
+					if (m_trees[ a ].size() <= m_trees[ b ].size())
+						m_trees[ a ].query_pairs( m_trees[ b ], m_pairs );
+					else
+						m_trees[ b ].query_pairs( m_trees[ a ], m_pairs );
+				}
+			}
+
+			m_islands.reset( objects.size() );
+			for (const ObjectPair &pair : m_pairs)
+			{
+				m_islands.link( pair.first, pair.second );
+			}
+			m_islands.build( m_results );
+		}
+
+		// spreads the low 10 bits of 'value' so there are two zero bits between each
+		inline static uint32_t expand_morton_bits( uint32_t value ) {
+			value = (value * 0x00010001u) & 0xFF0000FFu;
+			value = (value * 0x00000101u) & 0x0F00F00Fu;
+			value = (value * 0x00000011u) & 0xC30C30C3u;
+			value = (value * 0x00000005u) & 0x49249249u;
+			return value;
+		}
+
+		// 30-bit morton code of a point normalized to the unit cube
+		inline static uint32_t morton_code( const Vector3 &unit_point ) {
+			const auto quantize = []( const real_t value ) {
+				return static_cast<uint32_t>(std::min( std::max( value * real_t( 1024 ), real_t( 0 ) ), real_t( 1023 ) ));
+			};
+
+			return (expand_morton_bits( quantize( unit_point.x ) ) << 2)
+				| (expand_morton_bits( quantize( unit_point.y ) ) << 1)
+				| expand_morton_bits( quantize( unit_point.z ) );
+		}
+
+		void LinearBVH::build( const std::vector<index_t> &keys, const std::vector<frame_type> &frames, IThreadPool *pool ) {
+			const size_t count = keys.size();
+			m_leaf_count = count;
+			m_nodes.resize( count == 0 ? 0 : 2 * count - 1 );
+			m_leaves.clear();
+			m_refit_order.clear();
+			m_cost = 0;
+			m_build_cost = 0;
+
+			if (count == 0)
+				return;
+
+			AABB centroid_bounds = { frames[ 0 ].begin + frames[ 0 ].end, frames[ 0 ].begin + frames[ 0 ].end };
+			for (const frame_type &frame : frames)
+			{
+				centroid_bounds.encase( frame.begin + frame.end );
+			}
+
+			// centroids are kept doubled, only the ratio to the bounds matters
+			Vector3 scale = centroid_bounds.end - centroid_bounds.begin;
+			scale.x = scale.x > Epsilon ? 1 / scale.x : 0;
+			scale.y = scale.y > Epsilon ? 1 / scale.y : 0;
+			scale.z = scale.z > Epsilon ? 1 / scale.z : 0;
+
+			m_sorted.resize( count );
+			parallel_for(
+				count, pool,
+				[ this, &frames, &centroid_bounds, &scale ]( const size_t begin, const size_t end ) {
+					for (size_t i = begin; i < end; i++)
+					{
+						m_sorted[ i ] = { morton_code( (frames[ i ].begin + frames[ i ].end - centroid_bounds.begin) * scale ), i };
+					}
+				}
+			);
+
+			// sorted runs per thread, merged pairwise after
+			const size_t chunk = parallel_chunk( count, pool );
+			parallel_for(
+				count, pool,
+				[ this ]( const size_t begin, const size_t end ) {
+					std::sort( m_sorted.begin() + begin, m_sorted.begin() + end );
+				}
+			);
+
+			for (size_t width = chunk; width < count; width *= 2)
+			{
+				for (size_t begin = 0; begin + width < count; begin += 2 * width)
+				{
+					std::inplace_merge(
+						m_sorted.begin() + begin, m_sorted.begin() + begin + width, m_sorted.begin() + std::min( begin + 2 * width, count )
+					);
+				}
+			}
+
+			const index_t first_leaf = count - 1;
+			index_t max_key = 0;
+			for (const index_t key : keys)
+			{
+				max_key = std::max( max_key, key );
+			}
+			m_leaves.assign( max_key + 1, NullNode );
+
+			for (index_t i = 0; i < count; i++)
+			{
+				const index_t input = m_sorted[ i ].input;
+				m_nodes[ first_leaf + i ] = { frames[ input ], NullNode, NullNode, keys[ input ] };
+				m_leaves[ keys[ input ] ] = first_leaf + i;
+			}
+
+			// every inner node only depends on the sorted codes, they are built independently
+			parallel_for(
+				first_leaf, pool,
+				[ this ]( const size_t begin, const size_t end ) {
+					for (size_t i = begin; i < end; i++)
+					{
+						build_inner_node( i );
+					}
+				}
+			);
+
+			// reversed preorder puts every child before its parent
+			if (first_leaf > 0)
+			{
+				m_refit_order.reserve( first_leaf );
+				std::vector<index_t> stack{ 0 };
+				while (!stack.empty())
+				{
+					const index_t node = stack.back();
+					stack.pop_back();
+					if (node >= first_leaf)
+						continue;
+
+					m_refit_order.push_back( node );
+					stack.push_back( m_nodes[ node ].left );
+					stack.push_back( m_nodes[ node ].right );
+				}
+				std::reverse( m_refit_order.begin(), m_refit_order.end() );
+			}
+
+			refit();
+			m_build_cost = m_cost;
+		}
+
+		inline int32_t LinearBVH::common_prefix( int64_t i, int64_t j ) const {
+			if (j < 0 || j >= static_cast<int64_t>(m_leaf_count))
+				return -1;
+
+			const uint32_t code_i = m_sorted[ i ].code;
+			const uint32_t code_j = m_sorted[ j ].code;
+
+			// duplicate codes fall back on the sorted position
+			if (code_i == code_j)
+				return 32 + static_cast<int32_t>(simd::leading_zeros( static_cast<uint32_t>(i ^ j) ));
+
+			return static_cast<int32_t>(simd::leading_zeros( code_i ^ code_j ));
+		}
+
+		// karras 2012, finds the range covered by inner node 'index' and where it splits
+		void LinearBVH::build_inner_node( index_t index ) {
+			const int64_t i = static_cast<int64_t>(index);
+			const int64_t direction = common_prefix( i, i + 1 ) - common_prefix( i, i - 1 ) >= 0 ? 1 : -1;
+
+			const int32_t min_prefix = common_prefix( i, i - direction );
+			int64_t max_length = 2;
+			while (common_prefix( i, i + max_length * direction ) > min_prefix)
+			{
+				max_length *= 2;
+			}
+
+			int64_t length = 0;
+			for (int64_t step = max_length / 2; step >= 1; step /= 2)
+			{
+				if (common_prefix( i, i + (length + step) * direction ) > min_prefix)
+					length += step;
+			}
+
+			const int64_t j = i + length * direction;
+			const int32_t node_prefix = common_prefix( i, j );
+
+			int64_t split = 0;
+			int64_t step = length;
+			do
+			{
+				step = (step + 1) / 2;
+				if (common_prefix( i, i + (split + step) * direction ) > node_prefix)
+					split += step;
+			} while (step > 1);
+
+			const int64_t gamma = i + split * direction + std::min<int64_t>( direction, 0 );
+			const index_t first_leaf = m_leaf_count - 1;
+
+			Node &node = m_nodes[ index ];
+			node.left = std::min( i, j ) == gamma ? first_leaf + gamma : gamma;
+			node.right = std::max( i, j ) == gamma + 1 ? first_leaf + gamma + 1 : gamma + 1;
+			node.key = NullNode;
+		}
+
+		bool LinearBVH::refit() {
+			m_cost = 0;
+			for (const index_t index : m_refit_order)
+			{
+				Node &node = m_nodes[ index ];
+				node.frame = m_nodes[ node.left ].frame.encasing( m_nodes[ node.right ].frame );
+				m_cost += node.frame.measure();
+			}
+
+			return m_build_cost <= 0 || m_cost <= m_build_cost * m_rebuild_ratio;
+		}
+
+		void LinearBVH::query_pairs( PairList &pairs ) const {
+			for (index_t leaf = m_leaf_count == 0 ? 0 : m_leaf_count - 1; leaf < m_nodes.size(); leaf++)
+			{
+				const index_t key = m_nodes[ leaf ].key;
+				query(
+					m_nodes[ leaf ].frame,
+					[ &pairs, key ]( const index_t other ) {
+						if (key < other)
+							pairs.emplace_back( key, other );
+						return true;
+					}
+				);
+			}
+		}
+
+		void LinearBVH::query_pairs( const LinearBVH &other, PairList &pairs ) const {
+			if (m_leaf_count == 0)
+				return;
+
+			for (index_t leaf = m_leaf_count - 1; leaf < m_nodes.size(); leaf++)
+			{
+				const index_t key = m_nodes[ leaf ].key;
+				other.query(
+					m_nodes[ leaf ].frame,
+					[ &pairs, key ]( const index_t other_key ) {
+						pairs.emplace_back( std::min( key, other_key ), std::max( key, other_key ) );
+						return true;
+					}
+				);
+			}
+		}
+
+		LinearBVHBatcher3D::LinearBVHBatcher3D() : m_results{}, m_pairs{} {
+			m_results.reserve( BatchResultInitCapacity );
+			m_pairs.reserve( ObjectBatchInitCapacity );
+		}
+
+		void LinearBVHBatcher3D::invalidate() {
+			m_dirty = true;
+		}
+
+		void LinearBVHBatcher3D::rebuild( const std::vector<object_type> &objects ) {
+			// a (de)activated object or a new mask changes what a hierarchy holds
+			bool needs_build = m_dirty || m_active.size() != objects.size();
+			for (index_t i = 0; i < objects.size() && !needs_build; i++)
+			{
+				needs_build = is_batched( objects[ i ] ) != static_cast<bool>(m_active[ i ])
+					|| (m_active[ i ] && m_buckets.is_stale( i, objects[ i ].get_mask() ));
+			}
+
+			for (index_t bucket = 0; bucket < m_bvhs.size() && !needs_build; bucket++)
+			{
+				for (const index_t key : m_keys[ bucket ])
+				{
+					m_bvhs[ bucket ].set_frame( key, objects[ key ].get_frame().expanded( m_expand_margin ) );
+				}
+
+				needs_build = !m_bvhs[ bucket ].refit();
+			}
+
+			if (needs_build)
+			{
+				m_dirty = false;
+				for (index_t bucket = 0; bucket < m_keys.size(); bucket++)
+				{
+					m_keys[ bucket ].clear();
+					m_frames[ bucket ].clear();
+				}
+				m_active.resize( objects.size() );
+
+				for (index_t i = 0; i < objects.size(); i++)
+				{
+					m_active[ i ] = is_batched( objects[ i ] );
+					if (!m_active[ i ])
+						continue;
+
+					m_buckets.assign( i, objects[ i ].get_mask() );
+					const index_t bucket = m_buckets.get_bucket( i );
+					if (bucket >= m_keys.size())
+					{
+						m_keys.resize( bucket + 1 );
+						m_frames.resize( bucket + 1 );
+					}
+
+					m_keys[ bucket ].push_back( i );
+					m_frames[ bucket ].push_back( objects[ i ].get_frame().expanded( m_expand_margin ) );
+				}
+
+				m_bvhs.resize( m_keys.size() );
+				for (index_t bucket = 0; bucket < m_bvhs.size(); bucket++)
+				{
+					m_bvhs[ bucket ].build( m_keys[ bucket ], m_frames[ bucket ], m_thread_pool );
+				}
+			}
+
+			m_pairs.clear();
+
+			// bucket pairs whose layers never meet are skipped whole, the smaller hierarchy walks its leaves
+			for (index_t a = 0; a < m_bvhs.size(); a++)
+			{
+				if (m_buckets.meet( a, a ))
+					m_bvhs[ a ].query_pairs( m_pairs );
+
+				for (index_t b = a + 1; b < m_bvhs.size(); b++)
+				{
+					if (!m_buckets.meet( a, b ))
+						continue;
+
+					if (m_bvhs[ a ].size() <= m_bvhs[ b ].size())
+						m_bvhs[ a ].query_pairs( m_bvhs[ b ], m_pairs );
+					else
+						m_bvhs[ b ].query_pairs( m_bvhs[ a ], m_pairs );
+				}
+			}
+
+			m_islands.reset( objects.size() );
+			for (const ObjectPair &pair : m_pairs)
+			{
+				m_islands.link( pair.first, pair.second );
+			}
+			m_islands.build( m_results );
+		}
+
+		HashGridBatcher2D::HashGridBatcher2D() : m_results{}, m_pairs{} {
+			m_results.reserve( BatchResultInitCapacity );
+			m_pairs.reserve( ObjectBatchInitCapacity );
+		}
+
+		void HashGridBatcher2D::invalidate() {
+			m_dirty = true;
+		}
+
+		void HashGridBatcher2D::set_cell_size( real_t size ) {
+			m_cell_size = size;
+			m_dirty = true;
+		}
+
+		void HashGridBatcher2D::recalculate_cell_size( const std::vector<object_type> &objects ) {
+			if (m_cell_size > 0)
+			{
+				m_used_cell_size = m_cell_size;
+				return;
+			}
+
+			m_radii.clear();
+			for (const object_type &obj : objects)
+			{
+				if (!is_batched( obj ) || obj.get_shapes().empty())
+					continue;
+
+				const Shape2D &shape = obj.get_shape();
+				if (shape.get_type() == ShapeType2D::Circle)
+				{
+					m_radii.push_back( shape.get_circle().radius );
+					continue;
+				}
+
+				// not a circle, the half extent of the frame is the closest thing to a radius
+				const Vector2 size = obj.get_frame().end - obj.get_frame().begin;
+				m_radii.push_back( std::max( size.x, size.y ) / 2 );
+			}
+
+			if (m_radii.empty())
+			{
+				m_used_cell_size = 1;
+				return;
+			}
+
+			std::nth_element( m_radii.begin(), m_radii.begin() + m_radii.size() / 2, m_radii.end() );
+
+			// a median sized circle covers at most 4 cells
+			m_used_cell_size = 2 * (m_radii[ m_radii.size() / 2 ] + m_expand_margin);
+			if (m_used_cell_size <= Epsilon)
+				m_used_cell_size = 1;
+		}
+
+		// cells past this are clamped, so huge and infinite coordinates don't overflow the cast
+		constexpr int32_t HashGridCellLimit = 1 << 30;
+
+		inline static int32_t clamp_cell( real_t cell ) {
+			// also catches NaN
+			if (!(cell > -HashGridCellLimit))
+				return -HashGridCellLimit;
+			if (cell > HashGridCellLimit)
+				return HashGridCellLimit;
+			return static_cast<int32_t>(cell);
+		}
+
+		inline Vector2i HashGridBatcher2D::get_cell( const Vector2 &point ) const {
+			return {
+				clamp_cell( std::floor( point.x / m_used_cell_size ) ),
+				clamp_cell( std::floor( point.y / m_used_cell_size ) )
+			};
+		}
+
+		inline size_t HashGridBatcher2D::hash_cell( const Vector2i &cell ) const {
+			const uint32_t hash = (static_cast<uint32_t>(cell.x) * 73856093u) ^ (static_cast<uint32_t>(cell.y) * 19349663u);
+			return hash & (m_bucket_starts.size() - 2);
+		}
+
+		void HashGridBatcher2D::rebuild( const std::vector<object_type> &objects ) {
+			if (m_dirty)
+			{
+				m_dirty = false;
+				recalculate_cell_size( objects );
+			}
+
+			m_pairs.clear();
+			m_entries.clear();
+			m_oversized.clear();
+			m_frames.resize( objects.size() );
+
+			for (index_t i = 0; i < objects.size(); i++)
+			{
+				if (!is_batched( objects[ i ] ))
+					continue;
+
+				m_frames[ i ] = objects[ i ].get_frame().expanded( m_expand_margin );
+				if (m_buckets.is_stale( i, objects[ i ].get_mask() ))
+					m_buckets.assign( i, objects[ i ].get_mask() );
+
+				const Vector2i begin = get_cell( m_frames[ i ].begin );
+				const Vector2i end = get_cell( m_frames[ i ].end );
+				const int64_t cells = (int64_t( end.x ) - begin.x + 1) * (int64_t( end.y ) - begin.y + 1);
+				if (cells > MaxObjectCells)
+				{
+					m_oversized.push_back( i );
+					continue;
+				}
+
+				for (int32_t y = begin.y; y <= end.y; y++)
+				{
+					for (int32_t x = begin.x; x <= end.x; x++)
+					{
+						m_entries.push_back( { { x, y }, i, m_buckets.get_bucket( i ) } );
+					}
+				}
+			}
+
+			// power of two bucket count with a load factor of at most 0.5, plus one slot for the end offset
+			size_t bucket_count = 1u << 4;
+			while (bucket_count < m_entries.size() * 2)
+				bucket_count <<= 1;
+
+			// only grows, shrinking would reallocate when the world grows back
+			if (m_bucket_starts.size() < bucket_count + 1)
+				m_bucket_starts.resize( bucket_count + 1 );
+
+			bucket_count = m_bucket_starts.size() - 1;
+			std::fill( m_bucket_starts.begin(), m_bucket_starts.end(), 0 );
+
+			// counting sort of the entries by bucket
+			for (const Entry &entry : m_entries)
+			{
+				m_bucket_starts[ hash_cell( entry.cell ) + 1 ]++;
+			}
+
+			for (size_t i = 1; i <= bucket_count; i++)
+			{
+				m_bucket_starts[ i ] += m_bucket_starts[ i - 1 ];
+			}
+
+			m_sorted_entries.resize( m_entries.size() );
+			m_bucket_fill.assign( m_bucket_starts.begin(), m_bucket_starts.end() - 1 );
+			for (const Entry &entry : m_entries)
+			{
+				m_sorted_entries[ m_bucket_fill[ hash_cell( entry.cell ) ]++ ] = entry;
+			}
+
+			for (size_t bucket = 0; bucket < bucket_count; bucket++)
+			{
+				const size_t begin = m_bucket_starts[ bucket ];
+				const size_t end = m_bucket_starts[ bucket + 1 ];
+
+				for (size_t i = begin; i < end; i++)
+				{
+					const Entry &entry_a = m_sorted_entries[ i ];
+					const Rect &frame_a = m_frames[ entry_a.index ];
+
+					for (size_t j = i + 1; j < end; j++)
+					{
+						const Entry &entry_b = m_sorted_entries[ j ];
+
+						// different cells sharing a bucket
+						if (entry_a.cell != entry_b.cell)
+							continue;
+
+						if (!m_buckets.meet( entry_a.bucket, entry_b.bucket ))
+							continue;
+
+						const Rect &frame_b = m_frames[ entry_b.index ];
+						if (!frame_a.intersects( frame_b ))
+							continue;
+
+						// a pair shares every cell its overlap touches, only the cell holding the overlap's begin reports it
+						const Vector2 overlap_begin = {
+							std::max( frame_a.begin.x, frame_b.begin.x ), std::max( frame_a.begin.y, frame_b.begin.y )
+						};
+						if (get_cell( overlap_begin ) != entry_a.cell)
+							continue;
+
+						m_pairs.emplace_back( std::min( entry_a.index, entry_b.index ), std::max( entry_a.index, entry_b.index ) );
+					}
+				}
+			}
+
+			// oversized objects against everything, the ones before them in 'm_oversized' already tested them
+			for (index_t k = 0; k < m_oversized.size(); k++)
+			{
+				const index_t index_a = m_oversized[ k ];
+				const index_t bucket_a = m_buckets.get_bucket( index_a );
+				const Rect &frame_a = m_frames[ index_a ];
+				for (index_t index_b = 0; index_b < objects.size(); index_b++)
+				{
+					if (index_b == index_a || !is_batched( objects[ index_b ] ) || !m_buckets.meet( bucket_a, m_buckets.get_bucket( index_b ) ))
+						continue;
+
+					if (!frame_a.intersects( m_frames[ index_b ] ))
+						continue;
+
+					// 'm_oversized' is in index order
+					if (std::binary_search( m_oversized.begin(), m_oversized.begin() + k, index_b ))
+						continue;
+
+					m_pairs.emplace_back( std::min( index_a, index_b ), std::max( index_a, index_b ) );
+				}
+			}
+
+			m_islands.reset( objects.size() );
+			for (const ObjectPair &pair : m_pairs)
+			{
+				m_islands.link( pair.first, pair.second );
+			}
+			m_islands.build( m_results );
+		}
+
+		LooseOctree::LooseOctree( uint32_t max_depth ) : m_max_depth{ std::min( max_depth, 30u ) } {
+		}
+
+		void LooseOctree::reset( const frame_type &world ) {
+			const Vector3 size = world.end - world.begin;
+			value_type extent = std::max( std::max( size.x, size.y ), size.z ) * value_type( 0.5 );
+			if (extent <= Epsilon)
+				extent = 1;
+
+			m_nodes.clear();
+			m_free_nodes.clear();
+			m_nodes.push_back( {} );
+			Node &root = m_nodes.back();
+			root.center = (world.begin + world.end) * value_type( 0.5 );
+			// a little slack so frames touching the world's edge still count as inside
+			root.extent = extent * value_type( 1.0625 );
+			root.depth = 0;
+			root.parent = NullNode;
+			std::fill( std::begin( root.children ), std::end( root.children ), NullNode );
+			root.first = NullNode;
+			root.count = 0;
+
+			for (Item &item : m_items)
+			{
+				item.node = NullNode;
+			}
+			m_count = 0;
+			m_escaped = 0;
+		}
+
+		void LooseOctree::clear() {
+			m_nodes.clear();
+			m_free_nodes.clear();
+			m_items.clear();
+			m_count = 0;
+			m_escaped = 0;
+		}
+
+		void LooseOctree::insert( index_t key, const frame_type &frame ) {
+			if (m_nodes.empty())
+				reset( frame );
+
+			if (key >= m_items.size())
+				m_items.resize( key + 1, { frame_type{}, NullNode, NullNode, NullNode, false } );
+			else if (contains( key ))
+				remove( key );
+
+			const index_t node = find_node( frame );
+			Item &item = m_items[ key ];
+			item.frame = frame;
+			item.escaped = node == 0 && is_outside( m_nodes[ 0 ], frame );
+
+			link( key, node );
+			m_count++;
+			if (item.escaped)
+				m_escaped++;
+		}
+
+		bool LooseOctree::move( index_t key, const frame_type &frame ) {
+			Item &item = m_items[ key ];
+			if (!item.escaped && !is_misplaced( m_nodes[ item.node ], frame ))
+			{
+				item.frame = frame;
+				return false;
+			}
+
+			remove( key );
+			insert( key, frame );
+			return true;
+		}
+
+		void LooseOctree::remove( index_t key ) {
+			if (!contains( key ))
+				return;
+
+			unlink( key );
+			m_count--;
+			if (m_items[ key ].escaped)
+				m_escaped--;
+
+			m_items[ key ].node = NullNode;
+		}
+
+		void LooseOctree::query_pairs( PairList &pairs ) const {
+			if (m_nodes.empty())
+				return;
+
+			// both stacks hold at most 7 cells per level, the capped depth keeps them well inside
+			index_t homes[ 256 ];
+			index_t stack[ 256 ];
+			size_t home_count = 0;
+			homes[ home_count++ ] = 0;
+
+			while (home_count > 0)
+			{
+				const index_t home = homes[ --home_count ];
+				const uint32_t depth = m_nodes[ home ].depth;
+
+				for (const index_t child : m_nodes[ home ].children)
+				{
+					if (child != NullNode)
+						homes[ home_count++ ] = child;
+				}
+
+				for (index_t key = m_nodes[ home ].first; key != NullNode; key = m_items[ key ].next)
+				{
+					const frame_type &frame = m_items[ key ].frame;
+
+					size_t stack_size = 0;
+					stack[ stack_size++ ] = 0;
+					while (stack_size > 0)
+					{
+						const index_t current = stack[ --stack_size ];
+						const Node &node = m_nodes[ current ];
+
+						for (index_t other = node.first; other != NullNode; other = m_items[ other ].next)
+						{
+							// keys at the same depth find each other, the lower one reports
+							if (node.depth == depth && other <= key)
+								continue;
+
+							if (frame.intersects( m_items[ other ].frame ))
+								pairs.emplace_back( std::min( key, other ), std::max( key, other ) );
+						}
+
+						// deeper keys find this one themselves
+						if (node.depth == depth)
+							continue;
+
+						for (const index_t child : node.children)
+						{
+							if (child != NullNode && m_nodes[ child ].count > 0 && get_loose_bounds( m_nodes[ child ] ).intersects( frame ))
+								stack[ stack_size++ ] = child;
+						}
+					}
+				}
+			}
+		}
+
+		void LooseOctree::query_pairs( const LooseOctree &other, PairList &pairs ) const {
+			for (index_t key = 0; key < m_items.size(); key++)
+			{
+				if (m_items[ key ].node == NullNode)
+					continue;
+
+				other.query(
+					m_items[ key ].frame,
+					[ &pairs, key ]( const index_t other_key ) {
+						pairs.emplace_back( std::min( key, other_key ), std::max( key, other_key ) );
+						return true;
+					}
+				);
+			}
+		}
+
+		index_t LooseOctree::find_node( const frame_type &frame ) {
+			if (is_outside( m_nodes[ 0 ], frame ))
+				return 0;
+
+			const Vector3 center = (frame.begin + frame.end) * value_type( 0.5 );
+			const Vector3 size = frame.end - frame.begin;
+			const value_type largest = std::max( std::max( size.x, size.y ), size.z );
+
+			index_t node = 0;
+			while (m_nodes[ node ].depth < m_max_depth && largest <= m_nodes[ node ].extent)
+			{
+				const Node &current = m_nodes[ node ];
+				const uint32_t child = static_cast<uint32_t>(center.x >= current.center.x)
+					| (static_cast<uint32_t>(center.y >= current.center.y) << 1)
+					| (static_cast<uint32_t>(center.z >= current.center.z) << 2);
+
+				if (current.children[ child ] == NullNode)
+					create_node( node, child );
+
+				node = m_nodes[ node ].children[ child ];
+			}
+
+			return node;
+		}
+
+		index_t LooseOctree::create_node( index_t parent, uint32_t child ) {
+			Node node = {};
+			const Node &parent_node = m_nodes[ parent ];
+			node.extent = parent_node.extent * value_type( 0.5 );
+			node.center = parent_node.center + Vector3{
+				child & 1 ? node.extent : -node.extent,
+				child & 2 ? node.extent : -node.extent,
+				child & 4 ? node.extent : -node.extent
+			};
+			node.depth = parent_node.depth + 1;
+			node.parent = parent;
+			std::fill( std::begin( node.children ), std::end( node.children ), NullNode );
+			node.first = NullNode;
+			node.count = 0;
+
+			index_t index;
+			if (m_free_nodes.empty())
+			{
+				index = m_nodes.size();
+				m_nodes.push_back( node );
+			}
+			else
+			{
+				index = m_free_nodes.back();
+				m_free_nodes.pop_back();
+				m_nodes[ index ] = node;
+			}
+
+			m_nodes[ parent ].children[ child ] = index;
+			return index;
+		}
+
+		void LooseOctree::link( index_t key, index_t node ) {
+			Item &item = m_items[ key ];
+			item.node = node;
+			item.prev = NullNode;
+			item.next = m_nodes[ node ].first;
+			if (item.next != NullNode)
+				m_items[ item.next ].prev = key;
+			m_nodes[ node ].first = key;
+
+			for (index_t current = node; current != NullNode; current = m_nodes[ current ].parent)
+			{
+				m_nodes[ current ].count++;
+			}
+		}
+
+		void LooseOctree::unlink( index_t key ) {
+			const Item &item = m_items[ key ];
+			if (item.prev != NullNode)
+				m_items[ item.prev ].next = item.next;
+			else
+				m_nodes[ item.node ].first = item.next;
+
+			if (item.next != NullNode)
+				m_items[ item.next ].prev = item.prev;
+
+			// the cells that just emptied are a chain up from the key's cell, every other empty cell was freed earlier
+			index_t empty = NullNode;
+			for (index_t current = item.node; current != NullNode; current = m_nodes[ current ].parent)
+			{
+				if (--m_nodes[ current ].count == 0 && current != 0)
+					empty = current;
+			}
+
+			if (empty == NullNode)
+				return;
+
+			for (index_t &child : m_nodes[ m_nodes[ empty ].parent ].children)
+			{
+				if (child == empty)
+					child = NullNode;
+			}
+
+			for (index_t current = item.node; ; current = m_nodes[ current ].parent)
+			{
+				m_free_nodes.push_back( current );
+				if (current == empty)
+					break;
+			}
+		}
+
+		LooseOctreeBatcher3D::LooseOctreeBatcher3D() : m_results{}, m_pairs{} {
+			m_results.reserve( BatchResultInitCapacity );
+			m_pairs.reserve( ObjectBatchInitCapacity );
+		}
+
+		void LooseOctreeBatcher3D::invalidate() {
+			m_dirty = true;
+		}
+
+		void LooseOctreeBatcher3D::add_object( index_t index, const object_type &object ) {
+			// the pending rebuild will pick it up
+			if (m_dirty || !is_batched( object ))
+				return;
+
+			insert( index, object );
+		}
+
+		void LooseOctreeBatcher3D::insert( index_t index, const object_type &object ) {
+			m_buckets.assign( index, object.get_mask() );
+
+			const index_t bucket = m_buckets.get_bucket( index );
+			if (bucket >= m_octrees.size())
+				m_octrees.resize( bucket + 1 );
+
+			m_octrees[ bucket ].insert( index, object.get_frame() );
+		}
+
+		bool LooseOctreeBatcher3D::has_escaped() const {
+			for (const LooseOctree &octree : m_octrees)
+			{
+				if (octree.get_escaped_count() > 0)
+					return true;
+			}
+			return false;
+		}
+
+		void LooseOctreeBatcher3D::try_rebuild( const std::vector<object_type> &objects ) {
+			if (m_dirty || has_escaped())
+			{
+				rebuild( objects );
+				return;
+			}
+
+			for (index_t i = 0; i < objects.size(); i++)
+			{
+				const bool batched = is_batched( objects[ i ] );
+				const index_t bucket = m_buckets.get_bucket( i );
+				const bool in_tree = bucket != LayerBuckets::NullBucket && m_octrees[ bucket ].contains( i );
+
+				// a new mask means a different tree
+				if (in_tree && batched && !m_buckets.is_stale( i, objects[ i ].get_mask() ))
+				{
+					m_octrees[ bucket ].move( i, objects[ i ].get_frame() );
+					continue;
+				}
+
+				if (in_tree)
+					m_octrees[ bucket ].remove( i );
+
+				if (batched)
+					insert( i, objects[ i ] );
+			}
+
+			// an object just left the world, re-root now rather than carry it at the root
+			if (has_escaped())
+			{
+				rebuild( objects );
+				return;
+			}
+
+			update_pairs( objects.size() );
+		}
+
+		void LooseOctreeBatcher3D::rebuild( const std::vector<object_type> &objects ) {
+			m_dirty = false;
+
+			bool empty = true;
+			AABB world;
+			for (index_t i = 0; i < objects.size(); i++)
+			{
+				const object_type &obj = objects[ i ];
+				if (!is_batched( obj ))
+					continue;
+
+				m_buckets.assign( i, obj.get_mask() );
+				if (empty)
+					world = obj.get_frame();
+				else
+					world.encase( obj.get_frame() );
+				empty = false;
+			}
+
+			// every bucket's tree is rooted at the same world
+			m_octrees.resize( m_buckets.size() );
+			for (LooseOctree &octree : m_octrees)
+			{
+				octree.clear();
+				if (!empty)
+					octree.reset( world );
+			}
+
+			for (index_t i = 0; i < objects.size(); i++)
+			{
+				if (is_batched( objects[ i ] ))
+					m_octrees[ m_buckets.get_bucket( i ) ].insert( i, objects[ i ].get_frame() );
+			}
+
+			update_pairs( objects.size() );
+		}
+
+		void LooseOctreeBatcher3D::update_pairs( size_t object_count ) {
+			m_pairs.clear();
+
+			// bucket pairs whose layers never meet are skipped whole, the smaller tree walks its keys
+			for (index_t a = 0; a < m_octrees.size(); a++)
+			{
+				if (m_buckets.meet( a, a ))
+					m_octrees[ a ].query_pairs( m_pairs );
+
+				for (index_t b = a + 1; b < m_octrees.size(); b++)
+				{
+					if (!m_buckets.meet( a, b ))
+						continue;
+
+					if (m_octrees[ a ].size() <= m_octrees[ b ].size())
+						m_octrees[ a ].query_pairs( m_octrees[ b ], m_pairs );
+					else
+						m_octrees[ b ].query_pairs( m_octrees[ a ], m_pairs );
+				}
+			}
+
+			m_islands.reset( object_count );
+			for (const ObjectPair &pair : m_pairs)
+			{
+				m_islands.link( pair.first, pair.second );
+			}
+			m_islands.build( m_results );
+		}
+	}
+
+#pragma region(Solvers: Tearing my hear out)
+	namespace solvers
+	{
+		using I2D = Iterative2D;
+		using I3D = Iterative3D;
+
+		static_assert(std::is_same_v<ShapeType2D, I2D::shape_type_enum>, "expects I2D::shape_type_enum to be the same as ShapeType2D");
+		static_assert(std::is_same_v<ShapeType3D, I3D::shape_type_enum>, "expects I3D::shape_type_enum to be the same as ShapeType3D");
+
+		// false if the pair doesn't respond at all, how much each object moves is up to their masses
+		// statics push rigids and charecters, those only push their own type, clips only detect and soft bodies aren't simulated yet
+		inline static bool responds( ObjectType type_a, ObjectType type_b ) {
+			switch (get_collision_type( type_a, type_b ))
+			{
+			case CollisionType::RigidStaticCollision:
+			case CollisionType::CharecterStaticCollision:
+			case CollisionType::StaticRigidCollision:
+			case CollisionType::StaticCharecterCollision:
+			case CollisionType::RigidRigidCollision:
+			case CollisionType::CharecterCharecterCollision:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		// calls 'proc( shape_a, shape_b )' for the shape pairs whose frames come within 'reach', compound objects go through their shape trees
+		template <typename _OBJ, typename _PROC>
+		inline static void for_each_shape_pair( const _OBJ &object_a, const _OBJ &object_b, real_t reach, _PROC &&proc ) {
+			using frame_type = typename _OBJ::frame_type;
+			const auto &shapes_a = object_a.get_shapes();
+			const auto &shapes_b = object_b.get_shapes();
+
+			// the objects' frames already overlap
+			if (shapes_a.size() == 1 && shapes_b.size() == 1)
+			{
+				proc( index_t( 0 ), index_t( 0 ) );
+				return;
+			}
+
+			const auto &tree_a = object_a.get_shape_tree();
+			const auto &tree_b = object_b.get_shape_tree();
+			const auto offset = object_b.get_position() - object_a.get_position();
+
+			if (!tree_a.empty() && !tree_b.empty())
+			{
+				tree_a.query_pairs( tree_b, offset, reach, proc );
+				return;
+			}
+
+			if (!tree_a.empty())
+			{
+				for (index_t shape_b = 0; shape_b < shapes_b.size(); shape_b++)
+				{
+					frame_type frame = shapes_b[ shape_b ].get_bounding_box().expanded( reach );
+					frame.begin += offset;
+					frame.end += offset;
+					tree_a.query( frame, [ &proc, shape_b ]( const index_t shape_a ) { proc( shape_a, shape_b ); } );
+				}
+				return;
+			}
+
+			if (!tree_b.empty())
+			{
+				for (index_t shape_a = 0; shape_a < shapes_a.size(); shape_a++)
+				{
+					frame_type frame = shapes_a[ shape_a ].get_bounding_box().expanded( reach );
+					frame.begin -= offset;
+					frame.end -= offset;
+					tree_b.query( frame, [ &proc, shape_a ]( const index_t shape_b ) { proc( shape_a, shape_b ); } );
+				}
+				return;
+			}
+
+			for (index_t shape_a = 0; shape_a < shapes_a.size(); shape_a++)
+			{
+				frame_type frame_a = shapes_a[ shape_a ].get_bounding_box().expanded( reach );
+				frame_a.begin -= offset;
+				frame_a.end -= offset;
+				for (index_t shape_b = 0; shape_b < shapes_b.size(); shape_b++)
+				{
+					if (frame_a.intersects( shapes_b[ shape_b ].get_bounding_box() ))
+						proc( shape_a, shape_b );
+				}
+			}
+		}
+
+		// carries the impulses of last step's points over to this step's points with the same feature
+		template <typename _MANIFOLD>
+		inline static void match_points( const _MANIFOLD &previous, _MANIFOLD &current ) {
+			for (index_t i = 0; i < current.point_count; i++)
+			{
+				for (index_t j = 0; j < previous.point_count; j++)
+				{
+					if (previous.points[ j ].id == current.points[ i ].id)
+					{
+						current.points[ i ].normal_impulse = previous.points[ j ].normal_impulse;
+						current.points[ i ].tangent_impulse = previous.points[ j ].tangent_impulse;
+						break;
+					}
+				}
+			}
+		}
+
+		// how far 'polygon_b' is in front of edge 'edge' of 'polygon_a', negative when they overlap along its normal
+		inline static real_t edge_separation( const Polygon2D &polygon_a, const Vector2 &offset_a, index_t edge,
+																					const Polygon2D &polygon_b, const Vector2 &offset_b ) {
+			const Vector2 &normal = polygon_a.get_normals()[ edge ];
+			const Vector2 origin = polygon_a.get_points()[ edge ] + offset_a - offset_b;
+
+			real_t separation = std::numeric_limits<real_t>::max();
+			for (const Vector2 &point : polygon_b.get_points())
+			{
+				separation = std::min( separation, normal.dot( point - origin ) );
+			}
+			return separation;
+		}
+
+		// the edge of 'polygon_a' that 'polygon_b' is the furthest in front of
+		inline static real_t max_separation( const Polygon2D &polygon_a, const Vector2 &offset_a,
+																				 const Polygon2D &polygon_b, const Vector2 &offset_b, index_t &edge ) {
+			real_t best = -std::numeric_limits<real_t>::max();
+			for (index_t i = 0; i < polygon_a.get_normals().size(); i++)
+			{
+				const real_t separation = edge_separation( polygon_a, offset_a, i, polygon_b, offset_b );
+				if (separation > best)
+				{
+					best = separation;
+					edge = i;
+				}
+			}
+			return best;
+		}
+
+		// keeps the part of the segment behind the plane (normal . p <= offset), false if none of it is
+		inline static bool clip_segment( Vector2 segment[ 2 ], const Vector2 &normal, real_t offset ) {
+			const real_t distance_0 = normal.dot( segment[ 0 ] ) - offset;
+			const real_t distance_1 = normal.dot( segment[ 1 ] ) - offset;
+
+			if (distance_0 > 0 && distance_1 > 0)
+				return false;
+
+			if (distance_0 > 0)
+				segment[ 0 ] = segment[ 0 ] + (segment[ 1 ] - segment[ 0 ]) * (distance_0 / (distance_0 - distance_1));
+			else if (distance_1 > 0)
+				segment[ 1 ] = segment[ 1 ] + (segment[ 0 ] - segment[ 1 ]) * (distance_1 / (distance_1 - distance_0));
+
+			return true;
+		}
+
+		// separating axis test between two convex polygons placed at 'offset_a' and 'offset_b'
+		// the manifold gets up to two points on the incident edge, 'cache' remembers the axis for the next step
+		static bool collide_polygons( const Polygon2D &polygon_a, const Vector2 &offset_a,
+																	const Polygon2D &polygon_b, const Vector2 &offset_b,
+																	ContactCache &cache, Manifold2D &manifold ) {
+			manifold.point_count = 0;
+			if (polygon_a.get_normals().empty() || polygon_b.get_normals().empty())
+				return false;
+
+			// resting and hovering pairs are usually still separated along last step's axis
+			if (cache.axis_owner != ContactCache::NoFeature)
+			{
+				const bool owner_a = cache.axis_owner == 0;
+				const Polygon2D &owner = owner_a ? polygon_a : polygon_b;
+				if (cache.axis_edge < owner.get_normals().size()
+						&& (owner_a
+								? edge_separation( polygon_a, offset_a, cache.axis_edge, polygon_b, offset_b )
+								: edge_separation( polygon_b, offset_b, cache.axis_edge, polygon_a, offset_a )) > 0)
+					return false;
+			}
+
+			index_t edge_a = 0;
+			const real_t separation_a = max_separation( polygon_a, offset_a, polygon_b, offset_b, edge_a );
+			if (separation_a > 0)
+			{
+				cache.axis_owner = 0;
+				cache.axis_edge = static_cast<uint16_t>(edge_a);
+				return false;
+			}
+
+			index_t edge_b = 0;
+			const real_t separation_b = max_separation( polygon_b, offset_b, polygon_a, offset_a, edge_b );
+			if (separation_b > 0)
+			{
+				cache.axis_owner = 1;
+				cache.axis_edge = static_cast<uint16_t>(edge_b);
+				return false;
+			}
+
+			// the reference face is the least penetrating one, biased towards 'a' so it doesn't flip between steps
+			constexpr real_t relative_tolerance = real_t( 0.98 );
+			constexpr real_t absolute_tolerance = real_t( 0.001 );
+			const bool flip = separation_b > relative_tolerance * separation_a + absolute_tolerance;
+
+			const Polygon2D &reference = flip ? polygon_b : polygon_a;
+			const Polygon2D &incident = flip ? polygon_a : polygon_b;
+			const Vector2 &reference_offset = flip ? offset_b : offset_a;
+			const Vector2 &incident_offset = flip ? offset_a : offset_b;
+			const index_t reference_edge = flip ? edge_b : edge_a;
+			cache.axis_owner = flip ? 1 : 0;
+			cache.axis_edge = static_cast<uint16_t>(reference_edge);
+
+			const Vector2 &normal = reference.get_normals()[ reference_edge ];
+
+			// the incident edge faces the reference normal the most
+			index_t incident_edge = 0;
+			real_t min_dot = std::numeric_limits<real_t>::max();
+			for (index_t i = 0; i < incident.get_normals().size(); i++)
+			{
+				const real_t dot = normal.dot( incident.get_normals()[ i ] );
+				if (dot < min_dot)
+				{
+					min_dot = dot;
+					incident_edge = i;
+				}
+			}
+
+			const size_t incident_count = incident.get_points().size();
+			Vector2 segment[ 2 ] = {
+				incident.get_points()[ incident_edge ] + incident_offset,
+				incident.get_points()[ (incident_edge + 1) % incident_count ] + incident_offset
+			};
+
+			const size_t reference_count = reference.get_points().size();
+			const Vector2 reference_start = reference.get_points()[ reference_edge ] + reference_offset;
+			const Vector2 reference_end = reference.get_points()[ (reference_edge + 1) % reference_count ] + reference_offset;
+			const Vector2 tangent = (reference_end - reference_start).normalized();
+
+			// clip the incident edge to the reference edge's side planes
+			if (!clip_segment( segment, tangent * real_t( -1 ), -tangent.dot( reference_start ) ))
+				return false;
+			if (!clip_segment( segment, tangent, tangent.dot( reference_end ) ))
+				return false;
+
+			manifold.normal = flip ? normal * real_t( -1 ) : normal;
+			const real_t front = normal.dot( reference_start );
+			for (index_t i = 0; i < 2; i++)
+			{
+				const real_t separation = normal.dot( segment[ i ] ) - front;
+				if (separation > 0)
+					continue;
+
+				// the reference edge and the incident vertex the point was clipped from
+				const uint32_t id = (flip ? 0x80000000u : 0u)
+					| (static_cast<uint32_t>(reference_edge) << 16)
+					| static_cast<uint32_t>((incident_edge + i) % incident_count);
+				manifold.points[ manifold.point_count++ ] = { segment[ i ], -separation, id };
+			}
+
+			return manifold.point_count > 0;
+		}
+
+		// closest point of the rectangle to the circle's center, only takes a square root once they're known to overlap
+		static bool collide_circle_rect( const Circle &circle, const Vector2 &offset_a, const Rect &rect, const Vector2 &offset_b,
+																		 Manifold2D &manifold ) {
+			manifold.point_count = 0;
+			const Vector2 center = circle.center + offset_a - offset_b;
+			const Vector2 closest{ std::clamp( center.x, rect.begin.x, rect.end.x ), std::clamp( center.y, rect.begin.y, rect.end.y ) };
+			const Vector2 difference = closest - center;
+			const real_t distance_squared = difference.length_squared();
+
+			if (distance_squared >= circle.radius * circle.radius)
+				return false;
+
+			if (distance_squared > 0)
+			{
+				const real_t distance = std::sqrt( distance_squared );
+				manifold.normal = difference / distance;
+				manifold.points[ manifold.point_count++ ] = { closest + offset_b, circle.radius - distance };
+				return true;
+			}
+
+			// the center is inside, the circle leaves through the nearest side
+			const real_t sides[ 4 ] = { center.x - rect.begin.x, rect.end.x - center.x, center.y - rect.begin.y, rect.end.y - center.y };
+			const Vector2 normals[ 4 ] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+			const index_t side = std::min_element( sides, sides + 4 ) - sides;
+
+			manifold.normal = normals[ side ];
+			manifold.points[ manifold.point_count++ ] = { center + offset_b, sides[ side ] + circle.radius };
+			return true;
+		}
+
+		// finds the edge the circle's center is the furthest in front of, then checks that edge's voronoi regions
+		static bool collide_circle_polygon( const Circle &circle, const Vector2 &offset_a, const Polygon2D &polygon, const Vector2 &offset_b,
+																				Manifold2D &manifold ) {
+			manifold.point_count = 0;
+			const std::vector<Vector2> &points = polygon.get_points();
+			const std::vector<Vector2> &normals = polygon.get_normals();
+			if (normals.empty())
+				return false;
+
+			const Vector2 center = circle.center + offset_a - offset_b;
+			real_t separation = -std::numeric_limits<real_t>::max();
+			index_t edge = 0;
+			for (index_t i = 0; i < normals.size(); i++)
+			{
+				const real_t edge_separation = normals[ i ].dot( center - points[ i ] );
+				if (edge_separation > circle.radius)
+					return false;
+
+				if (edge_separation > separation)
+				{
+					separation = edge_separation;
+					edge = i;
+				}
+			}
+
+			// deep inside, the circle leaves through the closest edge
+			if (separation <= 0)
+			{
+				manifold.normal = -normals[ edge ];
+				manifold.points[ manifold.point_count++ ] = { center - normals[ edge ] * separation + offset_b, circle.radius - separation };
+				return true;
+			}
+
+			const Vector2 &start = points[ edge ];
+			const Vector2 &end = points[ (edge + 1) % points.size() ];
+			const Vector2 *corner = nullptr;
+			if ((center - start).dot( end - start ) <= 0)
+				corner = &start;
+			else if ((center - end).dot( start - end ) <= 0)
+				corner = &end;
+
+			if (corner == nullptr)
+			{
+				manifold.normal = -normals[ edge ];
+				manifold.points[ manifold.point_count++ ] = { center - normals[ edge ] * separation + offset_b, circle.radius - separation };
+				return true;
+			}
+
+			const Vector2 difference = *corner - center;
+			const real_t distance_squared = difference.length_squared();
+			if (distance_squared >= circle.radius * circle.radius)
+				return false;
+
+			const real_t distance = std::sqrt( distance_squared );
+			manifold.normal = distance > 0 ? difference / distance : -normals[ edge ];
+			manifold.points[ manifold.point_count++ ] = { *corner + offset_b, circle.radius - distance };
+			return true;
+		}
+
+		static bool collide_spheres( const Sphere &sphere_a, const Vector3 &offset_a, const Sphere &sphere_b, const Vector3 &offset_b,
+																 Manifold3D &manifold ) {
+			manifold.point_count = 0;
+			const Vector3 center_a = sphere_a.center + offset_a;
+			const Vector3 difference = sphere_b.center + offset_b - center_a;
+			const real_t distance_squared = difference.length_squared();
+			const real_t radii = sphere_a.radius + sphere_b.radius;
+
+			if (distance_squared >= radii * radii)
+				return false;
+
+			const real_t distance = std::sqrt( distance_squared );
+			manifold.normal = distance > 0 ? difference / distance : Vector3{ 0, 1, 0 };
+			manifold.points[ manifold.point_count++ ] = { center_a + manifold.normal * sphere_a.radius, radii - distance };
+			return true;
+		}
+
+		// only the lanes in 'mask' reach the square root
+		inline static void push_circle_contacts( const CirclePairs &circles, size_t first, uint32_t mask, std::vector<CircleContact> &contacts ) {
+			while (mask)
+			{
+				const size_t lane = first + simd::lowest_bit( mask );
+				mask &= mask - 1;
+
+				const Vector2 difference{ circles.b_x[ lane ] - circles.a_x[ lane ], circles.b_y[ lane ] - circles.a_y[ lane ] };
+				const real_t distance = difference.length();
+				const Vector2 normal = distance > 0 ? difference / distance : Vector2{ 1, 0 };
+				contacts.push_back( { circles.pairs[ lane ], normal, circles.a_radius[ lane ] + circles.b_radius[ lane ] - distance } );
+			}
+		}
+
+		void collide_circles( const CirclePairs &circles, std::vector<CircleContact> &contacts ) {
+			const size_t count = circles.size();
+			const size_t wide_count = count - count % simd::SimdWidth;
+
+			for (size_t first = 0; first < wide_count; first += simd::SimdWidth)
+			{
+				const uint32_t mask = simd::circle_overlap_mask(
+					circles.a_x.data(), circles.a_y.data(), circles.a_radius.data(),
+					circles.b_x.data(), circles.b_y.data(), circles.b_radius.data(),
+					first
+				);
+
+				if (mask)
+					push_circle_contacts( circles, first, mask, contacts );
+			}
+
+			// the tail doesn't fill a whole register
+			uint32_t mask = 0;
+			for (size_t lane = wide_count; lane < count; lane++)
+			{
+				const real_t dx = circles.b_x[ lane ] - circles.a_x[ lane ];
+				const real_t dy = circles.b_y[ lane ] - circles.a_y[ lane ];
+				const real_t radii = circles.a_radius[ lane ] + circles.b_radius[ lane ];
+				mask |= static_cast<uint32_t>(dx * dx + dy * dy < radii * radii) << (lane - wide_count);
+			}
+
+			if (mask)
+				push_circle_contacts( circles, wide_count, mask, contacts );
+		}
+
+		template<typename _VEC>
+		void TWideContacts<_VEC>::pack( const std::vector<constraint_type> &constraints, const std::vector<real_t> &inverse_masses ) {
+			m_group_count = 0;
+			m_sources.clear();
+			m_tail.clear();
+			m_object_slots.assign( inverse_masses.size(), 0 );
+			m_slot_lanes.resize( m_slot_counts.size() * simd::SimdWidth );
+
+			uint32_t open_slots = 0;
+			for (index_t i = 0; i < constraints.size(); i++)
+			{
+				const constraint_type &constraint = constraints[ i ];
+				const bool movable_a = inverse_masses[ constraint.body_a ] > 0;
+				const bool movable_b = inverse_masses[ constraint.body_b ] > 0;
+
+				// the open slots neither of the movable objects is waiting in yet
+				const uint32_t taken = (movable_a ? m_object_slots[ constraint.body_a ] : 0) | (movable_b ? m_object_slots[ constraint.body_b ] : 0);
+				uint32_t free = open_slots & ~taken;
+				if (!free)
+				{
+					if (open_slots == ~0u)
+					{
+						m_tail.push_back( i );
+						continue;
+					}
+					free = ~open_slots;
+					m_slot_counts[ simd::lowest_bit( free ) ] = 0;
+				}
+
+				const uint32_t slot_index = simd::lowest_bit( free );
+				const uint32_t bit = 1u << slot_index;
+				index_t *const lanes = &m_slot_lanes[ slot_index * simd::SimdWidth ];
+				open_slots |= bit;
+				lanes[ m_slot_counts[ slot_index ]++ ] = i;
+				if (movable_a)
+					m_object_slots[ constraint.body_a ] |= bit;
+				if (movable_b)
+					m_object_slots[ constraint.body_b ] |= bit;
+
+				if (m_slot_counts[ slot_index ] == simd::SimdWidth)
+				{
+					emit_group( constraints, inverse_masses, slot_index );
+					for (index_t lane = 0; lane < simd::SimdWidth; lane++)
+					{
+						m_object_slots[ constraints[ lanes[ lane ] ].body_a ] &= ~bit;
+						m_object_slots[ constraints[ lanes[ lane ] ].body_b ] &= ~bit;
+					}
+					open_slots &= ~bit;
+				}
+			}
+
+			// slots that never filled up go to the scalar loop
+			while (open_slots)
+			{
+				const index_t slot_index = simd::lowest_bit( open_slots );
+				open_slots &= open_slots - 1;
+				const auto lanes = m_slot_lanes.begin() + slot_index * simd::SimdWidth;
+				m_tail.insert( m_tail.end(), lanes, lanes + m_slot_counts[ slot_index ] );
+			}
+			std::sort( m_tail.begin(), m_tail.end() );
+		}
+
+		template<typename _VEC>
+		void TWideContacts<_VEC>::emit_group( const std::vector<constraint_type> &constraints, const std::vector<real_t> &inverse_masses, index_t slot ) {
+			const index_t *const lanes = &m_slot_lanes[ slot * simd::SimdWidth ];
+			const size_t first = m_group_count * simd::SimdWidth;
+			const size_t size = first + simd::SimdWidth;
+			m_group_count++;
+
+			m_offsets_a.resize( size );
+			m_offsets_b.resize( size );
+			m_inverse_masses_a.resize( size );
+			m_inverse_masses_b.resize( size );
+			m_masses.resize( size );
+			m_frictions.resize( size );
+			m_approaches.resize( size );
+			m_normal_impulses.resize( size );
+			for (index_t axis = 0; axis < dimensions; axis++)
+			{
+				m_normals[ axis ].resize( size );
+				m_tangent_impulses[ axis ].resize( size );
+			}
+
+			for (index_t lane = 0; lane < simd::SimdWidth; lane++)
+			{
+				const constraint_type &constraint = constraints[ lanes[ lane ] ];
+				const size_t index = first + lane;
+				m_offsets_a[ index ] = static_cast<int32_t>(constraint.body_a * dimensions);
+				m_offsets_b[ index ] = static_cast<int32_t>(constraint.body_b * dimensions);
+				m_inverse_masses_a[ index ] = inverse_masses[ constraint.body_a ];
+				m_inverse_masses_b[ index ] = inverse_masses[ constraint.body_b ];
+				m_masses[ index ] = constraint.mass;
+				m_frictions[ index ] = constraint.friction;
+				m_approaches[ index ] = constraint.approach;
+				m_normal_impulses[ index ] = constraint.normal_impulse;
+
+				const real_t *normal = &constraint.normal.x;
+				const real_t *tangent_impulse = &constraint.tangent_impulse.x;
+				for (index_t axis = 0; axis < dimensions; axis++)
+				{
+					m_normals[ axis ][ index ] = normal[ axis ];
+					m_tangent_impulses[ axis ][ index ] = tangent_impulse[ axis ];
+				}
+				m_sources.push_back( lanes[ lane ] );
+			}
+		}
+
+		template<typename _VEC>
+		real_t TWideContacts<_VEC>::solve( std::vector<vector_type> &velocities ) {
+			using simd::Wide;
+			static_assert(sizeof( vector_type ) == sizeof( real_t ) * dimensions, "the velocities are gathered as one array of reals");
+
+			real_t *const base = &velocities.data()->x;
+			const Wide zero = simd::splat( 0 );
+			const Wide one = simd::splat( 1 );
+			const Wide smallest = simd::splat( std::numeric_limits<real_t>::min() );
+			Wide largest_change = zero;
+
+			for (size_t first = 0; first < m_group_count * simd::SimdWidth; first += simd::SimdWidth)
+			{
+				const int32_t *offsets_a = &m_offsets_a[ first ];
+				const int32_t *offsets_b = &m_offsets_b[ first ];
+				const Wide inverse_mass_a = simd::load( &m_inverse_masses_a[ first ] );
+				const Wide inverse_mass_b = simd::load( &m_inverse_masses_b[ first ] );
+				const Wide mass = simd::load( &m_masses[ first ] );
+
+				Wide velocity_a[ dimensions ];
+				Wide velocity_b[ dimensions ];
+				Wide normal[ dimensions ];
+				for (index_t axis = 0; axis < dimensions; axis++)
+				{
+					velocity_a[ axis ] = simd::gather( base + axis, offsets_a );
+					velocity_b[ axis ] = simd::gather( base + axis, offsets_b );
+					normal[ axis ] = simd::load( &m_normals[ axis ][ first ] );
+				}
+
+				// the accumulated normal impulse only ever pushes
+				Wide closing = zero;
+				for (index_t axis = 0; axis < dimensions; axis++)
+				{
+					closing = closing + (velocity_b[ axis ] - velocity_a[ axis ]) * normal[ axis ];
+				}
+				const Wide normal_impulse = simd::load( &m_normal_impulses[ first ] );
+				const Wide accumulated = simd::max( normal_impulse - (closing + simd::load( &m_approaches[ first ] )) * mass, zero );
+				const Wide change = accumulated - normal_impulse;
+				simd::store( &m_normal_impulses[ first ], accumulated );
+				for (index_t axis = 0; axis < dimensions; axis++)
+				{
+					const Wide impulse = normal[ axis ] * change;
+					velocity_a[ axis ] = velocity_a[ axis ] - impulse * inverse_mass_a;
+					velocity_b[ axis ] = velocity_b[ axis ] + impulse * inverse_mass_b;
+				}
+
+				// friction stops the sliding, up to the cone the normal impulse allows
+				Wide relative[ dimensions ];
+				Wide along = zero;
+				for (index_t axis = 0; axis < dimensions; axis++)
+				{
+					relative[ axis ] = velocity_b[ axis ] - velocity_a[ axis ];
+					along = along + relative[ axis ] * normal[ axis ];
+				}
+
+				Wide tangent_impulse[ dimensions ];
+				Wide length_squared = zero;
+				for (index_t axis = 0; axis < dimensions; axis++)
+				{
+					const Wide sliding = relative[ axis ] - normal[ axis ] * along;
+					tangent_impulse[ axis ] = simd::load( &m_tangent_impulses[ axis ][ first ] ) - sliding * mass;
+					length_squared = length_squared + tangent_impulse[ axis ] * tangent_impulse[ axis ];
+				}
+
+				const Wide limit = simd::load( &m_frictions[ first ] ) * accumulated;
+				const Wide scale = simd::select(
+					simd::greater( length_squared, limit * limit ), limit / simd::sqrt( simd::max( length_squared, smallest ) ), one
+				);
+
+				Wide tangent_change_squared = zero;
+				for (index_t axis = 0; axis < dimensions; axis++)
+				{
+					const Wide clamped = tangent_impulse[ axis ] * scale;
+					const Wide tangent_change = clamped - simd::load( &m_tangent_impulses[ axis ][ first ] );
+					simd::store( &m_tangent_impulses[ axis ][ first ], clamped );
+					velocity_a[ axis ] = velocity_a[ axis ] - tangent_change * inverse_mass_a;
+					velocity_b[ axis ] = velocity_b[ axis ] + tangent_change * inverse_mass_b;
+					tangent_change_squared = tangent_change_squared + tangent_change * tangent_change;
+				}
+				largest_change = simd::max( largest_change, simd::max( change * change, tangent_change_squared ) );
+
+				// statics may be in several lanes, they're written back unchanged
+				for (index_t axis = 0; axis < dimensions; axis++)
+				{
+					simd::scatter( base + axis, offsets_a, velocity_a[ axis ] );
+					simd::scatter( base + axis, offsets_b, velocity_b[ axis ] );
+				}
+			}
+
+			return simd::reduce_max( largest_change );
+		}
+
+		template<typename _VEC>
+		void TWideContacts<_VEC>::unpack( std::vector<constraint_type> &constraints ) const {
+			for (size_t index = 0; index < m_sources.size(); index++)
+			{
+				constraint_type &constraint = constraints[ m_sources[ index ] ];
+				constraint.normal_impulse = m_normal_impulses[ index ];
+
+				real_t *tangent_impulse = &constraint.tangent_impulse.x;
+				for (index_t axis = 0; axis < dimensions; axis++)
+				{
+					tangent_impulse[ axis ] = m_tangent_impulses[ axis ][ index ];
+				}
+			}
+		}
+
+		// the 3D version of 'collide_circle_rect'
+		static bool collide_sphere_box( const Sphere &sphere, const Vector3 &offset_a, const AABB &box, const Vector3 &offset_b,
+																		Manifold3D &manifold ) {
+			manifold.point_count = 0;
+			const Vector3 center = sphere.center + offset_a - offset_b;
+			const Vector3 closest{
+				std::clamp( center.x, box.begin.x, box.end.x ),
+				std::clamp( center.y, box.begin.y, box.end.y ),
+				std::clamp( center.z, box.begin.z, box.end.z )
+			};
+			const Vector3 difference = closest - center;
+			const real_t distance_squared = difference.length_squared();
+
+			if (distance_squared >= sphere.radius * sphere.radius)
+				return false;
+
+			if (distance_squared > 0)
+			{
+				const real_t distance = std::sqrt( distance_squared );
+				manifold.normal = difference / distance;
+				manifold.points[ manifold.point_count++ ] = { closest + offset_b, sphere.radius - distance };
+				return true;
+			}
+
+			// the center is inside, the sphere leaves through the nearest face
+			const real_t faces[ 6 ] = {
+				center.x - box.begin.x, box.end.x - center.x,
+				center.y - box.begin.y, box.end.y - center.y,
+				center.z - box.begin.z, box.end.z - center.z
+			};
+			const Vector3 normals[ 6 ] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+			const index_t face = std::min_element( faces, faces + 6 ) - faces;
+
+			manifold.normal = normals[ face ];
+			manifold.points[ manifold.point_count++ ] = { center + offset_b, faces[ face ] + sphere.radius };
+			return true;
+		}
+
+		// boxes don't rotate, so the separating axis test only has the three world axes
+		// the manifold gets the four corners of the boxes' overlap on the least penetrating axis
+		static bool collide_boxes( const AABB &box_a, const Vector3 &offset_a, const AABB &box_b, const Vector3 &offset_b,
+															 Manifold3D &manifold ) {
+			manifold.point_count = 0;
+			const AABB a{ box_a.begin + offset_a, box_a.end + offset_a };
+			const AABB b{ box_b.begin + offset_b, box_b.end + offset_b };
+
+			index_t axis = 0;
+			real_t depth = std::numeric_limits<real_t>::max();
+			real_t sign = 1;
+			for (index_t i = 0; i < 3; i++)
+			{
+				const real_t forward = (&a.end.x)[ i ] - (&b.begin.x)[ i ];
+				const real_t backward = (&b.end.x)[ i ] - (&a.begin.x)[ i ];
+				if (forward <= 0 || backward <= 0)
+					return false;
+
+				if (std::min( forward, backward ) < depth)
+				{
+					depth = std::min( forward, backward );
+					sign = forward <= backward ? real_t( 1 ) : real_t( -1 );
+					axis = i;
+				}
+			}
+
+			manifold.normal = {};
+			(&manifold.normal.x)[ axis ] = sign;
+
+			// the overlap of the two faces touching along 'axis'
+			const index_t u = (axis + 1) % 3;
+			const index_t v = (axis + 2) % 3;
+			const real_t low_u = std::max( (&a.begin.x)[ u ], (&b.begin.x)[ u ] );
+			const real_t high_u = std::min( (&a.end.x)[ u ], (&b.end.x)[ u ] );
+			const real_t low_v = std::max( (&a.begin.x)[ v ], (&b.begin.x)[ v ] );
+			const real_t high_v = std::min( (&a.end.x)[ v ], (&b.end.x)[ v ] );
+			const real_t face = sign > 0 ? (&b.begin.x)[ axis ] : (&b.end.x)[ axis ];
+
+			const real_t corners[ 4 ][ 2 ] = { { low_u, low_v }, { high_u, low_v }, { high_u, high_v }, { low_u, high_v } };
+			for (index_t i = 0; i < 4; i++)
+			{
+				Vector3 point;
+				(&point.x)[ axis ] = face;
+				(&point.x)[ u ] = corners[ i ][ 0 ];
+				(&point.x)[ v ] = corners[ i ][ 1 ];
+
+				const uint32_t id = static_cast<uint32_t>((axis << 3) | (sign > 0 ? 4 : 0) | i);
+				manifold.points[ manifold.point_count++ ] = { point, depth, id };
+			}
+			return true;
+		}
+
+		// @returns true if 'point' (relative to the plane's origin) projects inside the plane's rectangle
+		inline static bool is_above_plane( const Plane &plane, const Vector3 &side, const Vector3 &forward, const Vector3 &point ) {
+			return std::abs( side.dot( point ) ) <= plane.size.x * real_t( 0.5 )
+				&& std::abs( forward.dot( point ) ) <= plane.size.y * real_t( 0.5 );
+		}
+
+		static bool collide_sphere_plane( const Sphere &sphere, const Vector3 &offset_a, const Plane &plane, const Vector3 &offset_b,
+																			Manifold3D &manifold ) {
+			manifold.point_count = 0;
+			const Vector3 normal = plane.normal.normalized();
+			const Vector3 center = sphere.center + offset_a - (plane.origin + offset_b);
+			const real_t distance = normal.dot( center );
+
+			if (distance >= sphere.radius)
+				return false;
+
+			Vector3 side, forward;
+			plane.get_axes( side, forward );
+			if (!is_above_plane( plane, side, forward, center ))
+				return false;
+
+			manifold.normal = -normal;
+			manifold.points[ manifold.point_count++ ] = { center - normal * sphere.radius + plane.origin + offset_b, sphere.radius - distance };
+			return true;
+		}
+
+		// every corner behind the plane is a contact point, at most four of them can be the deepest
+		static bool collide_box_plane( const AABB &box, const Vector3 &offset_a, const Plane &plane, const Vector3 &offset_b,
+																	 Manifold3D &manifold ) {
+			manifold.point_count = 0;
+			const Vector3 normal = plane.normal.normalized();
+			const Vector3 origin = plane.origin + offset_b;
+
+			// the corner furthest behind the plane decides the rejection before any of the others are looked at
+			const Vector3 deepest = box.support( -normal ) + offset_a;
+			if (normal.dot( deepest - origin ) >= 0)
+				return false;
+
+			Vector3 side, forward;
+			plane.get_axes( side, forward );
+
+			// insertion sort straight into the manifold, deepest first, a corner shallower than a full manifold's last is dropped
+			for (index_t i = 0; i < 8; i++)
+			{
+				const Vector3 corner{
+					(i & 1) ? box.end.x : box.begin.x,
+					(i & 2) ? box.end.y : box.begin.y,
+					(i & 4) ? box.end.z : box.begin.z
+				};
+				const Vector3 relative = corner + offset_a - origin;
+				const real_t distance = normal.dot( relative );
+				if (distance >= 0 || !is_above_plane( plane, side, forward, relative ))
+					continue;
+
+				index_t slot = manifold.point_count;
+				if (slot == Manifold3D::MaxPoints)
+				{
+					if (manifold.points[ slot - 1 ].depth >= -distance)
+						continue;
+					slot--;
+				}
+				else
+				{
+					manifold.point_count++;
+				}
+
+				for (; slot > 0 && manifold.points[ slot - 1 ].depth < -distance; slot--)
+				{
+					manifold.points[ slot ] = manifold.points[ slot - 1 ];
+				}
+				manifold.points[ slot ] = { corner + offset_a, -distance, static_cast<uint32_t>(i) };
+			}
+
+			if (manifold.point_count == 0)
+				return false;
+
+			manifold.normal = -normal;
+			return true;
+		}
+
+		// Ericson's closest point of the triangle 'abc' to 'point', found through the voronoi region it falls in
+		inline static Vector3 closest_on_triangle( const Vector3 &point, const Vector3 &a, const Vector3 &b, const Vector3 &c ) {
+			const Vector3 ab = b - a;
+			const Vector3 ac = c - a;
+			const Vector3 ap = point - a;
+			const real_t d1 = ab.dot( ap );
+			const real_t d2 = ac.dot( ap );
+			if (d1 <= 0 && d2 <= 0)
+				return a;
+
+			const Vector3 bp = point - b;
+			const real_t d3 = ab.dot( bp );
+			const real_t d4 = ac.dot( bp );
+			if (d3 >= 0 && d4 <= d3)
+				return b;
+
+			const real_t vc = d1 * d4 - d3 * d2;
+			if (vc <= 0 && d1 >= 0 && d3 <= 0)
+				return a + ab * (d1 / (d1 - d3));
+
+			const Vector3 cp = point - c;
+			const real_t d5 = ab.dot( cp );
+			const real_t d6 = ac.dot( cp );
+			if (d6 >= 0 && d5 <= d6)
+				return c;
+
+			const real_t vb = d5 * d2 - d1 * d6;
+			if (vb <= 0 && d2 >= 0 && d6 <= 0)
+				return a + ac * (d2 / (d2 - d6));
+
+			const real_t va = d3 * d6 - d5 * d4;
+			if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0)
+				return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+			const real_t denominator = 1 / (va + vb + vc);
+			return a + ab * (vb * denominator) + ac * (vc * denominator);
+		}
+
+		// a sphere against one triangle, 'normal' points from the triangle to the sphere and 'closest' is on the triangle
+		// one-sided triangles push a center that's behind them out through their front
+		template <bool _ONE_SIDED>
+		inline static bool sphere_triangle_contact( const Vector3 &center, real_t radius, const Vector3 &a, const Vector3 &b, const Vector3 &c,
+																								Vector3 &normal, real_t &depth, Vector3 &closest ) {
+			const Vector3 face_normal = (b - a).cross( c - a );
+			if (face_normal.length_squared() <= Epsilon * Epsilon)
+				return false;
+
+			closest = closest_on_triangle( center, a, b, c );
+			const Vector3 difference = center - closest;
+			const Vector3 front = face_normal.normalized();
+			const real_t height = front.dot( center - a );
+			if (_ONE_SIDED && height < 0 && (difference - front * height).length_squared() <= Epsilon * Epsilon)
+			{
+				normal = front;
+				depth = radius - height;
+				return true;
+			}
+
+			const real_t distance_squared = difference.length_squared();
+			if (distance_squared >= radius * radius)
+				return false;
+
+			const real_t distance = std::sqrt( distance_squared );
+			normal = distance > 0 ? difference / distance : front;
+			depth = radius - distance;
+			return true;
+		}
+
+		// the deepest triangle makes the contact
+		template <typename _MESH>
+		static bool collide_sphere_triangles( const Sphere &sphere, const Vector3 &offset_a, const _MESH &mesh, const Vector3 &offset_b,
+																					Manifold3D &manifold ) {
+			manifold.point_count = 0;
+			const Vector3 center = sphere.center + offset_a - offset_b;
+			const AABB region = calculate_bounding_box( Sphere{ center, sphere.radius } );
+
+			real_t best_depth = 0;
+			mesh.query_triangles(
+				region,
+				[ & ]( const Vector3 &a, const Vector3 &b, const Vector3 &c, index_t face ) {
+					(void)face;
+					Vector3 normal, closest;
+					real_t depth;
+					if (!sphere_triangle_contact<_MESH::OneSided>( center, sphere.radius, a, b, c, normal, depth, closest ) || depth <= best_depth)
+						return;
+
+					best_depth = depth;
+					manifold.normal = -normal;
+					manifold.points[ 0 ] = { closest + offset_b, depth };
+					manifold.point_count = 1;
+				}
+			);
+
+			return manifold.point_count > 0;
+		}
+
+		// how a box and a triangle overlap, 'normal' is the least penetrating axis pointing from the box to the triangle
+		struct BoxTriangleAxis
+		{
+			enum class Kind
+			{
+				Triangle,
+				Box,
+				Edges,
+			};
+
+			Vector3 normal;
+			real_t depth;
+			Kind kind;
+		};
+
+		// separating axis test of a box against a triangle: the triangle's normal, the box's axes and the nine edge crossings
+		// the edge axes have to clearly beat the faces, so boxes sliding over a mesh don't catch on the edges between triangles
+		// one-sided triangles are prisms running back from their front, they always push along it and the other axes only reject
+		template <bool _ONE_SIDED>
+		static bool box_triangle_axis( const AABB &box, const Vector3 corners[ 3 ], const Vector3 &face_normal, BoxTriangleAxis &result ) {
+			constexpr real_t relative_tolerance = real_t( 0.95 );
+			constexpr real_t absolute_tolerance = real_t( 0.001 );
+			const Vector3 center = (box.begin + box.end) * real_t( 0.5 );
+			const Vector3 half = (box.end - box.begin) * real_t( 0.5 );
+			const Vector3 front = _ONE_SIDED ? face_normal.normalized() : Vector3{};
+
+			result.depth = std::numeric_limits<real_t>::max();
+			const auto test = [ & ]( const Vector3 &direction, typename BoxTriangleAxis::Kind kind ) {
+				const real_t length_squared = direction.length_squared();
+				if (length_squared <= Epsilon * Epsilon)
+					return true;
+
+				const Vector3 axis = direction / std::sqrt( length_squared );
+				const real_t radius = half.x * std::abs( axis.x ) + half.y * std::abs( axis.y ) + half.z * std::abs( axis.z );
+				const real_t middle = axis.dot( center );
+				real_t low = axis.dot( corners[ 0 ] );
+				real_t high = low;
+				for (index_t i = 1; i < 3; i++)
+				{
+					low = std::min( low, axis.dot( corners[ i ] ) );
+					high = std::max( high, axis.dot( corners[ i ] ) );
+				}
+
+				// how far the box has to move against and along the axis, a prism has no end on the side its back faces
+				const real_t forward = middle + radius - low;
+				const real_t backward = high - (middle - radius);
+				const real_t facing = axis.dot( front );
+				if ((backward <= 0 && facing > -Epsilon) || (forward <= 0 && facing < Epsilon))
+					return false;
+
+				if (_ONE_SIDED)
+				{
+					if (kind == BoxTriangleAxis::Kind::Triangle)
+						result = { -axis, backward, kind };
+					return true;
+				}
+
+				const real_t depth = std::min( forward, backward );
+				const bool better = kind == BoxTriangleAxis::Kind::Edges
+					? depth < result.depth * relative_tolerance - absolute_tolerance
+					: depth < result.depth;
+				if (better)
+					result = { forward < backward ? axis : -axis, depth, kind };
+				return true;
+			};
+
+			if (!test( face_normal, BoxTriangleAxis::Kind::Triangle ))
+				return false;
+
+			const Vector3 axes[ 3 ] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+			for (const Vector3 &axis : axes)
+			{
+				if (!test( axis, BoxTriangleAxis::Kind::Box ))
+					return false;
+			}
+
+			for (index_t i = 0; i < 3; i++)
+			{
+				const Vector3 edge = corners[ (i + 1) % 3 ] - corners[ i ];
+				for (const Vector3 &axis : axes)
+				{
+					if (!test( edge.cross( axis ), BoxTriangleAxis::Kind::Edges ))
+						return false;
+				}
+
+				// the prism's sides
+				if (_ONE_SIDED && !test( edge.cross( face_normal ), BoxTriangleAxis::Kind::Edges ))
+					return false;
+			}
+			return true;
+		}
+
+		// the corners of the box under the triangle and the triangle's corners inside the box, or one point when neither touch
+		// all the triangles' points are pooled, the deepest one picks the normal and the points facing about the same way are kept
+		template <typename _MESH>
+		static bool collide_box_triangles( const AABB &box, const Vector3 &offset_a, const _MESH &mesh, const Vector3 &offset_b,
+																			 Manifold3D &manifold ) {
+			struct Candidate
+			{
+				typename Manifold3D::Point point;
+				Vector3 normal;
+			};
+			constexpr index_t max_candidates = 32;
+			// how far the normals of the points kept can be from the deepest one's (about 25 degrees)
+			constexpr real_t coplanar = real_t( 0.9 );
+
+			manifold.point_count = 0;
+			const AABB local{ box.begin + offset_a - offset_b, box.end + offset_a - offset_b };
+
+			Candidate candidates[ max_candidates ];
+			index_t count = 0;
+			const auto add = [ &candidates, &count ]( const Candidate &candidate ) {
+				if (count < max_candidates)
+				{
+					candidates[ count++ ] = candidate;
+					return;
+				}
+
+				// full, the shallowest point makes room
+				Candidate *shallowest = std::min_element(
+					candidates, candidates + count,
+					[]( const Candidate &left, const Candidate &right ) { return left.point.depth < right.point.depth; }
+				);
+				if (shallowest->point.depth < candidate.point.depth)
+					*shallowest = candidate;
+			};
+
+			mesh.query_triangles(
+				local,
+				[ & ]( const Vector3 &a, const Vector3 &b, const Vector3 &c, index_t face ) {
+					const Vector3 corners[ 3 ] = { a, b, c };
+					const Vector3 face_normal = (b - a).cross( c - a );
+					if (face_normal.length_squared() <= Epsilon * Epsilon)
+						return;
+
+					BoxTriangleAxis axis;
+					if (!box_triangle_axis<_MESH::OneSided>( local, corners, face_normal, axis ))
+						return;
+
+					// the box gets pushed along 'push'
+					const Vector3 push = -axis.normal;
+					const real_t box_low = push.dot( (local.begin + local.end) * real_t( 0.5 ) )
+						- (std::abs( push.x ) * (local.end.x - local.begin.x) + std::abs( push.y ) * (local.end.y - local.begin.y)
+							 + std::abs( push.z ) * (local.end.z - local.begin.z)) * real_t( 0.5 );
+					const index_t first = count;
+
+					if (axis.kind == BoxTriangleAxis::Kind::Triangle)
+					{
+						for (index_t i = 0; i < 8; i++)
+						{
+							const Vector3 corner{
+								(i & 1) ? local.end.x : local.begin.x,
+								(i & 2) ? local.end.y : local.begin.y,
+								(i & 4) ? local.end.z : local.begin.z
+							};
+							const real_t depth = push.dot( a - corner );
+							if (depth <= 0)
+								continue;
+
+							bool inside = true;
+							for (index_t edge = 0; edge < 3 && inside; edge++)
+							{
+								inside = (corners[ (edge + 1) % 3 ] - corners[ edge ]).cross( corner - corners[ edge ] ).dot( face_normal ) >= 0;
+							}
+
+							if (inside)
+								add( { { corner + offset_b, depth, static_cast<uint32_t>(i) }, axis.normal } );
+						}
+					}
+
+					for (index_t i = 0; i < 3; i++)
+					{
+						const Vector3 &corner = corners[ i ];
+						if (corner.x <= local.begin.x || corner.x >= local.end.x
+								|| corner.y <= local.begin.y || corner.y >= local.end.y
+								|| corner.z <= local.begin.z || corner.z >= local.end.z)
+							continue;
+
+						const uint32_t id = static_cast<uint32_t>(8 + face * 3 + i);
+						add( { { corner + offset_b, push.dot( corner ) - box_low, id }, axis.normal } );
+					}
+
+					if (count > first)
+						return;
+
+					// edge against edge (or face), the triangle's corner deepest in the box stands in for the contact
+					const Vector3 *deepest = std::max_element(
+						corners, corners + 3,
+						[ &push ]( const Vector3 &left, const Vector3 &right ) { return push.dot( left ) < push.dot( right ); }
+					);
+					const Vector3 point{
+						std::clamp( deepest->x, local.begin.x, local.end.x ),
+						std::clamp( deepest->y, local.begin.y, local.end.y ),
+						std::clamp( deepest->z, local.begin.z, local.end.z )
+					};
+					add( { { point + offset_b, axis.depth, static_cast<uint32_t>(0x80000000u | face) }, axis.normal } );
+				}
+			);
+
+			if (count == 0)
+				return false;
+
+			const Candidate &deepest = *std::max_element(
+				candidates, candidates + count,
+				[]( const Candidate &left, const Candidate &right ) { return left.point.depth < right.point.depth; }
+			);
+			const Vector3 normal = deepest.normal;
+
+			// only the points facing about the same way as the deepest one, the deeper copy of a shared corner stays
+			index_t kept = 0;
+			for (index_t i = 0; i < count; i++)
+			{
+				if (candidates[ i ].normal.dot( normal ) < coplanar)
+					continue;
+
+				bool duplicate = false;
+				for (index_t j = 0; j < kept && !duplicate; j++)
+				{
+					Candidate &other = candidates[ j ];
+					duplicate = other.point.id == candidates[ i ].point.id
+						|| (other.point.position - candidates[ i ].point.position).length_squared() <= Epsilon * Epsilon;
+					if (duplicate && candidates[ i ].point.depth > other.point.depth)
+						other = candidates[ i ];
+				}
+
+				if (!duplicate)
+					candidates[ kept++ ] = candidates[ i ];
+			}
+
+			manifold.normal = normal;
+			if (kept <= Manifold3D::MaxPoints)
+			{
+				for (index_t i = 0; i < kept; i++)
+				{
+					manifold.points[ manifold.point_count++ ] = candidates[ i ].point;
+				}
+				return true;
+			}
+
+			// the deepest point, then the ones spreading the contact area the most
+			const auto add_furthest = [ & ]( const auto &score ) {
+				index_t best = 0;
+				real_t best_score = -std::numeric_limits<real_t>::max();
+				for (index_t i = 0; i < kept; i++)
+				{
+					const real_t value = score( candidates[ i ].point );
+					if (value > best_score)
+					{
+						best_score = value;
+						best = i;
+					}
+				}
+				manifold.points[ manifold.point_count++ ] = candidates[ best ].point;
+			};
+
+			// out of the (about) deepest points, the one furthest from the middle so resting boxes start from a corner
+			Vector3 middle{};
+			real_t max_depth = 0;
+			for (index_t i = 0; i < kept; i++)
+			{
+				middle += candidates[ i ].point.position / static_cast<real_t>(kept);
+				max_depth = std::max( max_depth, candidates[ i ].point.depth );
+			}
+			add_furthest( [ &middle, max_depth ]( const typename Manifold3D::Point &point ) {
+				return point.depth >= max_depth - Epsilon ? (point.position - middle).length_squared() : real_t( -1 );
+			} );
+
+			const Vector3 first = manifold.points[ 0 ].position;
+			add_furthest( [ &first ]( const typename Manifold3D::Point &point ) {
+				return (point.position - first).length_squared();
+			} );
+
+			const Vector3 second = manifold.points[ 1 ].position;
+			add_furthest( [ &first, &second, &normal ]( const typename Manifold3D::Point &point ) {
+				return std::abs( (second - first).cross( point.position - first ).dot( normal ) );
+			} );
+
+			// the last one goes the furthest out of the triangle the first three make
+			const Vector3 third = manifold.points[ 2 ].position;
+			const Vector3 winding = (second - first).cross( third - first );
+			add_furthest( [ &first, &second, &third, &winding ]( const typename Manifold3D::Point &point ) {
+				return -std::min( {
+					(second - first).cross( point.position - first ).dot( winding ),
+					(third - second).cross( point.position - second ).dot( winding ),
+					(first - third).cross( point.position - third ).dot( winding )
+				} );
+			} );
+			return true;
+		}
+
+		// GJK and EPA work on the minkowski difference 'a - b', they only need the shapes' 'support'
+		constexpr index_t GjkMaxIterations = 32;
+		constexpr index_t EpaMaxIterations = 64;
+		// relative progress under which GJK stops, squared distance under which the shapes touch
+		constexpr real_t GjkTolerance = real_t( 1e-6 );
+		constexpr real_t GjkTouchTolerance = real_t( 1e-8 );
+		// how much closer than the polytope's face a new support point has to be for EPA to keep expanding
+		constexpr real_t EpaTolerance = real_t( 1e-4 );
+
+		template <typename _VEC>
+		struct TSupportPoint
+		{
+			// on the minkowski difference
+			_VEC point;
+			// the point of 'a' that made it, contact points are interpolated from these
+			_VEC on_a;
+			// the search direction that made it
+			_VEC direction;
+		};
+
+		// two shapes placed at their offsets, '_A' and '_B' only need a 'support' member
+		template <typename _VEC, typename _A, typename _B>
+		struct TMinkowski
+		{
+			inline TSupportPoint<_VEC> support( const _VEC &direction ) const {
+				const _VEC on_a = shape_a.support( direction ) + offset_a;
+				return { on_a - (shape_b.support( -direction ) + offset_b), on_a, direction };
+			}
+
+			const _A &shape_a;
+			_VEC offset_a;
+			const _B &shape_b;
+			_VEC offset_b;
+		};
+
+		template <typename _VEC>
+		struct TSimplex
+		{
+			static constexpr index_t Dimensions = TFrame<_VEC>::dimensions;
+			static constexpr index_t Capacity = Dimensions + 1;
+
+			inline _VEC closest() const {
+				_VEC point{};
+				for (index_t i = 0; i < count; i++)
+				{
+					point = point + points[ i ].point * weights[ i ];
+				}
+				return point;
+			}
+
+			// the point of the first shape that 'closest' comes from
+			inline _VEC closest_on_a() const {
+				_VEC point{};
+				for (index_t i = 0; i < count; i++)
+				{
+					point = point + points[ i ].on_a * weights[ i ];
+				}
+				return point;
+			}
+
+			inline bool contains( const _VEC &point ) const {
+				for (index_t i = 0; i < count; i++)
+				{
+					if (points[ i ].point.distance_squared( point ) <= GjkTouchTolerance)
+						return true;
+				}
+				return false;
+			}
+
+			// keeps only the listed points, with their barycentric weights
+			template <index_t N>
+			inline void keep( const index_t( &indices )[ N ], const real_t( &new_weights )[ N ] ) {
+				TSupportPoint<_VEC> kept[ N ];
+				for (index_t i = 0; i < N; i++)
+				{
+					kept[ i ] = points[ indices[ i ] ];
+				}
+				for (index_t i = 0; i < N; i++)
+				{
+					points[ i ] = kept[ i ];
+					weights[ i ] = new_weights[ i ];
+				}
+				count = N;
+			}
+
+			TSupportPoint<_VEC> points[ Capacity ];
+			real_t weights[ Capacity ] = {};
+			index_t count = 0;
+		};
+
+		template <typename _VEC>
+		inline static void reduce_segment( TSimplex<_VEC> &simplex ) {
+			const _VEC &a = simplex.points[ 0 ].point;
+			const _VEC ab = simplex.points[ 1 ].point - a;
+			const real_t length_squared = ab.length_squared();
+			const real_t t = length_squared > 0 ? -a.dot( ab ) / length_squared : 0;
+
+			if (t <= 0)
+				simplex.keep( { 0 }, { 1 } );
+			else if (t >= 1)
+				simplex.keep( { 1 }, { 1 } );
+			else
+				simplex.keep( { 0, 1 }, { 1 - t, t } );
+		}
+
+		// the closest point of the triangle to the origin by its voronoi regions (Ericson, 5.1.5)
+		template <typename _VEC>
+		inline static void reduce_triangle( TSimplex<_VEC> &simplex ) {
+			const _VEC &a = simplex.points[ 0 ].point;
+			const _VEC &b = simplex.points[ 1 ].point;
+			const _VEC &c = simplex.points[ 2 ].point;
+			const _VEC ab = b - a;
+			const _VEC ac = c - a;
+
+			const real_t d1 = -ab.dot( a );
+			const real_t d2 = -ac.dot( a );
+			if (d1 <= 0 && d2 <= 0)
+				return simplex.keep( { 0 }, { 1 } );
+
+			const real_t d3 = -ab.dot( b );
+			const real_t d4 = -ac.dot( b );
+			if (d3 >= 0 && d4 <= d3)
+				return simplex.keep( { 1 }, { 1 } );
+
+			const real_t vc = d1 * d4 - d3 * d2;
+			if (vc <= 0 && d1 >= 0 && d3 <= 0)
+			{
+				const real_t t = d1 / (d1 - d3);
+				return simplex.keep( { 0, 1 }, { 1 - t, t } );
+			}
+
+			const real_t d5 = -ab.dot( c );
+			const real_t d6 = -ac.dot( c );
+			if (d6 >= 0 && d5 <= d6)
+				return simplex.keep( { 2 }, { 1 } );
+
+			const real_t vb = d5 * d2 - d1 * d6;
+			if (vb <= 0 && d2 >= 0 && d6 <= 0)
+			{
+				const real_t t = d2 / (d2 - d6);
+				return simplex.keep( { 0, 2 }, { 1 - t, t } );
+			}
+
+			const real_t va = d3 * d6 - d5 * d4;
+			if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+			{
+				const real_t t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+				return simplex.keep( { 1, 2 }, { 1 - t, t } );
+			}
+
+			const real_t total = va + vb + vc;
+			if (total <= 0)
+			{
+				// collinear points, the longest edge covers the other two
+				const real_t lengths[ 3 ] = { ab.length_squared(), ac.length_squared(), (c - b).length_squared() };
+				if (lengths[ 0 ] >= lengths[ 1 ] && lengths[ 0 ] >= lengths[ 2 ])
+					simplex.keep( { 0, 1 }, { 0, 0 } );
+				else if (lengths[ 1 ] >= lengths[ 2 ])
+					simplex.keep( { 0, 2 }, { 0, 0 } );
+				else
+					simplex.keep( { 1, 2 }, { 0, 0 } );
+				return reduce_segment( simplex );
+			}
+
+			simplex.keep( { 0, 1, 2 }, { va / total, vb / total, vc / total } );
+		}
+
+		// the closest point of the tetrahedron's faces that have the origin in front of them
+		inline static void reduce_tetrahedron( TSimplex<Vector3> &simplex ) {
+			// each face with the vertex opposite to it
+			constexpr index_t faces[ 4 ][ 4 ] = { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } };
+
+			TSimplex<Vector3> best{};
+			real_t best_distance = std::numeric_limits<real_t>::max();
+			bool outside = false;
+			for (const auto &face : faces)
+			{
+				const Vector3 &a = simplex.points[ face[ 0 ] ].point;
+				const Vector3 normal = (simplex.points[ face[ 1 ] ].point - a).cross( simplex.points[ face[ 2 ] ].point - a );
+				const real_t origin_side = -normal.dot( a );
+				const real_t opposite_side = normal.dot( simplex.points[ face[ 3 ] ].point - a );
+
+				// a flat tetrahedron can't hold the origin, all of its faces are checked
+				if (origin_side * opposite_side > 0 && std::abs( opposite_side ) > GjkTouchTolerance)
+					continue;
+
+				outside = true;
+				TSimplex<Vector3> candidate{};
+				candidate.points[ 0 ] = simplex.points[ face[ 0 ] ];
+				candidate.points[ 1 ] = simplex.points[ face[ 1 ] ];
+				candidate.points[ 2 ] = simplex.points[ face[ 2 ] ];
+				candidate.count = 3;
+				reduce_triangle( candidate );
+
+				const real_t distance = candidate.closest().length_squared();
+				if (distance < best_distance)
+				{
+					best_distance = distance;
+					best = candidate;
+				}
+			}
+
+			if (!outside)
+			{
+				simplex.weights[ 0 ] = simplex.weights[ 1 ] = simplex.weights[ 2 ] = simplex.weights[ 3 ] = real_t( 0.25 );
+				return;
+			}
+			simplex = best;
+		}
+
+		// @returns true if the simplex holds the origin, otherwise the simplex is cut down to the feature closest to it
+		template <typename _VEC>
+		inline static bool reduce_simplex( TSimplex<_VEC> &simplex ) {
+			switch (simplex.count)
+			{
+			case 1:
+				simplex.weights[ 0 ] = 1;
+				return false;
+			case 2:
+				reduce_segment( simplex );
+				return false;
+			case 3:
+				reduce_triangle( simplex );
+				return simplex.count == TSimplex<_VEC>::Capacity;
+			default:
+				if constexpr (TSimplex<_VEC>::Dimensions == 3)
+				{
+					reduce_tetrahedron( simplex );
+					return simplex.count == TSimplex<_VEC>::Capacity;
+				}
+				return false;
+			}
+		}
+
+		// @returns true if the shapes overlap (or touch), 'simplex' is left with the points of the last step
+		// @note starts from the directions in 'cache' and stores the final ones back there
+		template <typename _VEC, typename _MINKOWSKI>
+		static bool gjk( const _MINKOWSKI &minkowski, ContactCache &cache, TSimplex<_VEC> &simplex ) {
+			constexpr index_t dimensions = TSimplex<_VEC>::Dimensions;
+
+			const auto add_support = [&minkowski, &simplex]( const _VEC &direction ) {
+				const TSupportPoint<_VEC> support = minkowski.support( direction );
+				if (simplex.contains( support.point ))
+					return false;
+				simplex.points[ simplex.count++ ] = support;
+				return true;
+			};
+
+			simplex.count = 0;
+			for (index_t i = 0; i < cache.simplex_count && i < TSimplex<_VEC>::Capacity; i++)
+			{
+				_VEC direction{};
+				for (index_t axis = 0; axis < dimensions; axis++)
+				{
+					(&direction.x)[ axis ] = cache.simplex[ i ][ axis ];
+				}
+				add_support( direction );
+			}
+
+			if (simplex.count == 0)
+			{
+				_VEC direction = minkowski.offset_b - minkowski.offset_a;
+				if (direction.length_squared() <= GjkTouchTolerance)
+					direction.x = 1;
+				add_support( direction );
+			}
+
+			bool overlap = false;
+			for (index_t iteration = 0; iteration < GjkMaxIterations; iteration++)
+			{
+				if (reduce_simplex( simplex ))
+				{
+					overlap = true;
+					break;
+				}
+
+				const _VEC closest = simplex.closest();
+				const real_t distance = closest.length_squared();
+				if (distance <= GjkTouchTolerance)
+				{
+					overlap = true;
+					break;
+				}
+
+				// no support point gets closer to the origin than the simplex already is
+				const TSupportPoint<_VEC> support = minkowski.support( -closest );
+				if (distance - closest.dot( support.point ) <= GjkTolerance * distance || !add_support( -closest ))
+					break;
+			}
+
+			cache.simplex_count = static_cast<uint8_t>(simplex.count);
+			for (index_t i = 0; i < simplex.count; i++)
+			{
+				for (index_t axis = 0; axis < dimensions; axis++)
+				{
+					cache.simplex[ i ][ axis ] = (&simplex.points[ i ].direction.x)[ axis ];
+				}
+			}
+			return overlap;
+		}
+
+		// expands the overlapping simplex to the polygon edge closest to the origin, its normal and distance are the penetration
+		template <typename _MINKOWSKI>
+		static bool epa( const _MINKOWSKI &minkowski, const TSimplex<Vector2> &simplex, Manifold2D &manifold ) {
+			std::vector<TSupportPoint<Vector2>> polytope{ simplex.points, simplex.points + simplex.count };
+
+			// touching shapes leave less than a triangle behind
+			const auto push_support = [&minkowski, &polytope]( const Vector2 &direction ) {
+				const TSupportPoint<Vector2> support = minkowski.support( direction );
+				for (const auto &point : polytope)
+				{
+					if (point.point.distance_squared( support.point ) <= GjkTouchTolerance)
+						return false;
+				}
+				polytope.push_back( support );
+				return true;
+			};
+
+			if (polytope.size() == 1 && !push_support( { 1, 0 } ) && !push_support( { -1, 0 } ))
+				return false;
+
+			if (polytope.size() == 2)
+			{
+				const Vector2 normal = (polytope[ 1 ].point - polytope[ 0 ].point).tangent();
+				if (!push_support( normal ) && !push_support( -normal ))
+					return false;
+			}
+
+			const Vector2 edge_1 = polytope[ 1 ].point - polytope[ 0 ].point;
+			const Vector2 edge_2 = polytope[ 2 ].point - polytope[ 0 ].point;
+			const real_t winding = edge_1.x * edge_2.y - edge_1.y * edge_2.x;
+			if (std::abs( winding ) <= GjkTouchTolerance)
+				return false;
+
+			// counter clockwise, so (edge.y, -edge.x) points out
+			if (winding < 0)
+				std::swap( polytope[ 1 ], polytope[ 2 ] );
+
+			Vector2 normal{};
+			real_t distance = 0;
+			index_t edge = 0;
+			for (index_t iteration = 0; iteration < EpaMaxIterations; iteration++)
+			{
+				distance = std::numeric_limits<real_t>::max();
+				for (index_t i = 0; i < polytope.size(); i++)
+				{
+					const Vector2 edge_vector = polytope[ (i + 1) % polytope.size() ].point - polytope[ i ].point;
+					if (edge_vector.length_squared() <= 0)
+						continue;
+
+					const Vector2 edge_normal = edge_vector.tangent().normalized();
+					const real_t edge_distance = edge_normal.dot( polytope[ i ].point );
+					if (edge_distance < distance)
+					{
+						distance = edge_distance;
+						normal = edge_normal;
+						edge = i;
+					}
+				}
+
+				const TSupportPoint<Vector2> support = minkowski.support( normal );
+				if (normal.dot( support.point ) - distance <= EpaTolerance)
+					break;
+
+				polytope.insert( polytope.begin() + (edge + 1), support );
+			}
+
+			if (distance <= 0)
+				return false;
+
+			const TSupportPoint<Vector2> &start = polytope[ edge ];
+			const TSupportPoint<Vector2> &end = polytope[ (edge + 1) % polytope.size() ];
+			const Vector2 edge_vector = end.point - start.point;
+			const real_t t = std::clamp( -start.point.dot( edge_vector ) / edge_vector.length_squared(), real_t( 0 ), real_t( 1 ) );
+
+			manifold.normal = normal;
+			manifold.points[ 0 ] = { start.on_a + (end.on_a - start.on_a) * t, distance };
+			manifold.point_count = 1;
+			return true;
+		}
+
+		// expands the overlapping simplex to the polytope face closest to the origin, its normal and distance are the penetration
+		template <typename _MINKOWSKI>
+		static bool epa( const _MINKOWSKI &minkowski, const TSimplex<Vector3> &simplex, Manifold3D &manifold ) {
+			struct Face
+			{
+				index_t vertices[ 3 ];
+				Vector3 normal;
+				real_t distance;
+			};
+
+			std::vector<TSupportPoint<Vector3>> polytope{ simplex.points, simplex.points + simplex.count };
+
+			const auto push_support = [&minkowski, &polytope]( const Vector3 &direction ) {
+				const TSupportPoint<Vector3> support = minkowski.support( direction );
+				for (const auto &point : polytope)
+				{
+					if (point.point.distance_squared( support.point ) <= GjkTouchTolerance)
+						return false;
+				}
+				polytope.push_back( support );
+				return true;
+			};
+
+			// touching shapes leave less than a tetrahedron behind, search around the missing dimensions
+			if (polytope.size() == 1)
+			{
+				const Vector3 axes[ 3 ] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+				for (const Vector3 &axis : axes)
+				{
+					if (push_support( axis ) || push_support( -axis ))
+						break;
+				}
+				if (polytope.size() == 1)
+					return false;
+			}
+
+			if (polytope.size() == 2)
+			{
+				const Vector3 line = polytope[ 1 ].point - polytope[ 0 ].point;
+				const Vector3 side = line.cross( std::abs( line.x ) < std::abs( line.y ) ? Vector3{ 1, 0, 0 } : Vector3{ 0, 1, 0 } );
+				const Vector3 directions[ 4 ] = { side, -side, line.cross( side ), -line.cross( side ) };
+				for (const Vector3 &direction : directions)
+				{
+					if (!push_support( direction ))
+						continue;
+					if ((polytope[ 2 ].point - polytope[ 0 ].point).cross( line ).length_squared() > GjkTouchTolerance)
+						break;
+					polytope.pop_back();
+				}
+				if (polytope.size() == 2)
+					return false;
+			}
+
+			if (polytope.size() == 3)
+			{
+				const Vector3 normal =
+					(polytope[ 1 ].point - polytope[ 0 ].point).cross( polytope[ 2 ].point - polytope[ 0 ].point );
+				if (!push_support( normal ) && !push_support( -normal ))
+					return false;
+			}
+
+			const Vector3 interior = (polytope[ 0 ].point + polytope[ 1 ].point + polytope[ 2 ].point + polytope[ 3 ].point) * real_t( 0.25 );
+			const auto make_face = [&polytope, &interior]( index_t a, index_t b, index_t c ) {
+				Face face{ { a, b, c }, {}, std::numeric_limits<real_t>::max() };
+				const Vector3 normal = (polytope[ b ].point - polytope[ a ].point).cross( polytope[ c ].point - polytope[ a ].point );
+				if (normal.length_squared() <= 0)
+					return face;
+
+				face.normal = normal.normalized();
+				if (face.normal.dot( polytope[ a ].point - interior ) < 0)
+				{
+					std::swap( face.vertices[ 1 ], face.vertices[ 2 ] );
+					face.normal = -face.normal;
+				}
+				face.distance = face.normal.dot( polytope[ a ].point );
+				return face;
+			};
+
+			std::vector<Face> faces{ make_face( 0, 1, 2 ), make_face( 0, 3, 1 ), make_face( 0, 2, 3 ), make_face( 1, 3, 2 ) };
+			std::vector<std::pair<index_t, index_t>> horizon;
+
+			index_t closest = 0;
+			for (index_t iteration = 0; iteration < EpaMaxIterations; iteration++)
+			{
+				closest = 0;
+				for (index_t i = 1; i < faces.size(); i++)
+				{
+					if (faces[ i ].distance < faces[ closest ].distance)
+						closest = i;
+				}
+
+				const Vector3 normal = faces[ closest ].normal;
+				const TSupportPoint<Vector3> support = minkowski.support( normal );
+				if (normal.dot( support.point ) - faces[ closest ].distance <= EpaTolerance)
+					break;
+
+				// every face the new point sees goes, the edges only one of them had make the horizon
+				const index_t vertex = polytope.size();
+				polytope.push_back( support );
+				horizon.clear();
+				for (index_t i = faces.size(); i-- > 0;)
+				{
+					const Face &face = faces[ i ];
+					if (face.normal.dot( support.point - polytope[ face.vertices[ 0 ] ].point ) <= 0)
+						continue;
+
+					for (index_t e = 0; e < 3; e++)
+					{
+						const std::pair<index_t, index_t> edge{ face.vertices[ e ], face.vertices[ (e + 1) % 3 ] };
+						const auto shared = std::find( horizon.begin(), horizon.end(), std::make_pair( edge.second, edge.first ) );
+						if (shared != horizon.end())
+							horizon.erase( shared );
+						else
+							horizon.push_back( edge );
+					}
+
+					faces[ i ] = faces.back();
+					faces.pop_back();
+				}
+
+				for (const auto &edge : horizon)
+				{
+					faces.push_back( make_face( edge.first, edge.second, vertex ) );
+				}
+
+				if (faces.empty())
+					return false;
+			}
+
+			const Face &face = faces[ closest ];
+			if (face.distance <= 0 || face.distance == std::numeric_limits<real_t>::max())
+				return false;
+
+			// barycentric coordinates of the origin's projection on the face
+			const TSupportPoint<Vector3> &a = polytope[ face.vertices[ 0 ] ];
+			const TSupportPoint<Vector3> &b = polytope[ face.vertices[ 1 ] ];
+			const TSupportPoint<Vector3> &c = polytope[ face.vertices[ 2 ] ];
+			const Vector3 ab = b.point - a.point;
+			const Vector3 ac = c.point - a.point;
+			const Vector3 ap = face.normal * face.distance - a.point;
+			const real_t d00 = ab.dot( ab );
+			const real_t d01 = ab.dot( ac );
+			const real_t d11 = ac.dot( ac );
+			const real_t d20 = ap.dot( ab );
+			const real_t d21 = ap.dot( ac );
+			const real_t denominator = d00 * d11 - d01 * d01;
+			const real_t v = denominator > 0 ? (d11 * d20 - d01 * d21) / denominator : 0;
+			const real_t w = denominator > 0 ? (d00 * d21 - d01 * d20) / denominator : 0;
+
+			manifold.normal = face.normal;
+			manifold.points[ 0 ] = { a.on_a * (1 - v - w) + b.on_a * v + c.on_a * w, face.distance };
+			manifold.point_count = 1;
+			return true;
+		}
+
+		// any two shapes with a 'support', the manifold only gets the deepest point
+		template <typename _VEC, index_t _MAX_POINTS, typename _A, typename _B>
+		static bool collide_convex( const _A &shape_a, const _VEC &offset_a, const _B &shape_b, const _VEC &offset_b,
+																ContactCache &cache, TManifold<_VEC, _MAX_POINTS> &manifold ) {
+			manifold.point_count = 0;
+
+			const TMinkowski<_VEC, _A, _B> minkowski{ shape_a, offset_a, shape_b, offset_b };
+			TSimplex<_VEC> simplex{};
+			if (!gjk( minkowski, cache, simplex ))
+				return false;
+
+			return epa( minkowski, simplex, manifold );
+		}
+
+		// the closest points of the segments 'start_a end_a' and 'start_b end_b' (Ericson, 5.1.9)
+		template <typename _VEC>
+		inline static void closest_on_segments( const _VEC &start_a, const _VEC &end_a, const _VEC &start_b, const _VEC &end_b,
+																						_VEC &closest_a, _VEC &closest_b ) {
+			const _VEC direction_a = end_a - start_a;
+			const _VEC direction_b = end_b - start_b;
+			const _VEC between = start_a - start_b;
+			const real_t length_a = direction_a.length_squared();
+			const real_t length_b = direction_b.length_squared();
+			const real_t f = direction_b.dot( between );
+
+			// both zero when the segments are points
+			real_t s = 0;
+			real_t t = 0;
+			if (length_a <= GjkTouchTolerance)
+			{
+				if (length_b > GjkTouchTolerance)
+					t = std::clamp<real_t>( f / length_b, 0, 1 );
+			}
+			else
+			{
+				const real_t c = direction_a.dot( between );
+				if (length_b <= GjkTouchTolerance)
+				{
+					s = std::clamp<real_t>( -c / length_a, 0, 1 );
+				}
+				else
+				{
+					// parallel segments start from the start of 'a', any point of the overlap is as close
+					const real_t b = direction_a.dot( direction_b );
+					const real_t denominator = length_a * length_b - b * b;
+					s = denominator > 0 ? std::clamp<real_t>( (b * f - c * length_b) / denominator, 0, 1 ) : 0;
+					t = (b * s + f) / length_b;
+
+					if (t < 0)
+					{
+						t = 0;
+						s = std::clamp<real_t>( -c / length_a, 0, 1 );
+					}
+					else if (t > 1)
+					{
+						t = 1;
+						s = std::clamp<real_t>( (b - c) / length_a, 0, 1 );
+					}
+				}
+			}
+
+			closest_a = start_a + direction_a * s;
+			closest_b = start_b + direction_b * t;
+		}
+
+		// two points grown by their radii, every capsule routine comes down to this
+		template <typename _VEC, index_t _MAX_POINTS>
+		inline static bool collide_rounded_points( const _VEC &point_a, real_t radius_a, const _VEC &point_b, real_t radius_b,
+																							 TManifold<_VEC, _MAX_POINTS> &manifold ) {
+			manifold.point_count = 0;
+			const _VEC difference = point_b - point_a;
+			const real_t distance_squared = difference.length_squared();
+			const real_t radii = radius_a + radius_b;
+
+			if (distance_squared >= radii * radii)
+				return false;
+
+			_VEC up{};
+			up.y = 1;
+			const real_t distance = std::sqrt( distance_squared );
+			manifold.normal = distance > 0 ? difference / distance : up;
+			manifold.points[ manifold.point_count++ ] = { point_a + manifold.normal * radius_a, radii - distance };
+			return true;
+		}
+
+		template <typename _VEC, index_t _MAX_POINTS>
+		inline static bool collide_capsule_round( const TCapsule<_VEC> &capsule, const _VEC &offset_a, const TRound<_VEC> &round, const _VEC &offset_b,
+																							TManifold<_VEC, _MAX_POINTS> &manifold ) {
+			const _VEC center = round.center + offset_b - offset_a;
+			return collide_rounded_points( capsule.closest_point( center ) + offset_a, capsule.radius, center + offset_a, round.radius, manifold );
+		}
+
+		template <typename _VEC, index_t _MAX_POINTS>
+		inline static bool collide_capsules( const TCapsule<_VEC> &capsule_a, const _VEC &offset_a, const TCapsule<_VEC> &capsule_b, const _VEC &offset_b,
+																				 TManifold<_VEC, _MAX_POINTS> &manifold ) {
+			_VEC closest_a, closest_b;
+			closest_on_segments(
+				capsule_a.start + offset_a, capsule_a.end + offset_a, capsule_b.start + offset_b, capsule_b.end + offset_b,
+				closest_a, closest_b
+			);
+			return collide_rounded_points( closest_a, capsule_a.radius, closest_b, capsule_b.radius, manifold );
+		}
+
+		// rays are segments with no radius
+		template <typename _VEC, index_t _MAX_POINTS>
+		inline static bool collide_capsule_ray( const TCapsule<_VEC> &capsule, const _VEC &offset_a, const TRay<_VEC> &ray, const _VEC &offset_b,
+																						TManifold<_VEC, _MAX_POINTS> &manifold ) {
+			_VEC closest_a, closest_b;
+			closest_on_segments(
+				capsule.start + offset_a, capsule.end + offset_a, ray.origin + offset_b, ray.origin + ray.extent + offset_b,
+				closest_a, closest_b
+			);
+			return collide_rounded_points( closest_a, capsule.radius, closest_b, real_t( 0 ), manifold );
+		}
+
+		// the segment inside a capsule, GJK only needs its two ends
+		template <typename _VEC>
+		struct TCapsuleCore
+		{
+			inline _VEC support( const _VEC &direction ) const {
+				return direction.dot( capsule.end - capsule.start ) > 0 ? capsule.end : capsule.start;
+			}
+
+			const TCapsule<_VEC> &capsule;
+		};
+
+		// GJK's distance from the capsule's segment to any convex shape, only a segment that's already inside needs EPA on the whole capsule
+		template <typename _VEC, index_t _MAX_POINTS, typename _B>
+		static bool collide_capsule_convex( const TCapsule<_VEC> &capsule, const _VEC &offset_a, const _B &shape_b, const _VEC &offset_b,
+																				ContactCache &cache, TManifold<_VEC, _MAX_POINTS> &manifold ) {
+			manifold.point_count = 0;
+
+			const TCapsuleCore<_VEC> core{ capsule };
+			const TMinkowski<_VEC, TCapsuleCore<_VEC>, _B> minkowski{ core, offset_a, shape_b, offset_b };
+			TSimplex<_VEC> simplex{};
+			if (gjk( minkowski, cache, simplex ))
+				return collide_convex( capsule, offset_a, shape_b, offset_b, cache, manifold );
+
+			// the simplex' closest point to the origin is the gap from the shape to the segment
+			const _VEC gap = simplex.closest();
+			const real_t distance_squared = gap.length_squared();
+			if (distance_squared >= capsule.radius * capsule.radius)
+				return false;
+
+			const real_t distance = std::sqrt( distance_squared );
+			manifold.normal = -gap / distance;
+			manifold.points[ manifold.point_count++ ] = { simplex.closest_on_a() - gap, capsule.radius - distance };
+			return true;
+		}
+
+		// the end of the segment deepest behind the plane is all that can touch it first
+		inline static bool collide_capsule_plane( const Capsule3D &capsule, const Vector3 &offset_a, const Plane &plane, const Vector3 &offset_b,
+																							Manifold3D &manifold ) {
+			const Vector3 tip = TCapsuleCore<Vector3>{ capsule }.support( -plane.normal );
+			return collide_sphere_plane( Sphere{ tip, capsule.radius }, offset_a, plane, offset_b, manifold );
+		}
+
+		// one triangle for GJK
+		struct TriangleCore
+		{
+			inline Vector3 support( const Vector3 &direction ) const {
+				const real_t dots[ 3 ] = { direction.dot( corners[ 0 ] ), direction.dot( corners[ 1 ] ), direction.dot( corners[ 2 ] ) };
+				return corners[ std::max_element( dots, dots + 3 ) - dots ];
+			}
+
+			Vector3 corners[ 3 ];
+		};
+
+		// like 'collide_sphere_triangles' with a sphere on each end and one at the segment's closest point in between
+		template <typename _MESH>
+		static bool collide_capsule_triangles( const Capsule3D &capsule, const Vector3 &offset_a, const _MESH &mesh, const Vector3 &offset_b,
+																					 Manifold3D &manifold ) {
+			manifold.point_count = 0;
+			const Capsule3D local{ capsule.start + offset_a - offset_b, capsule.end + offset_a - offset_b, capsule.radius };
+			const TCapsuleCore<Vector3> core{ local };
+
+			real_t best_depth = 0;
+			const auto keep = [ & ]( const Vector3 &normal, real_t depth, const Vector3 &closest ) {
+				if (depth <= best_depth)
+					return;
+
+				best_depth = depth;
+				manifold.normal = -normal;
+				manifold.points[ 0 ] = { closest + offset_b, depth };
+				manifold.point_count = 1;
+			};
+
+			mesh.query_triangles(
+				calculate_bounding_box( local ),
+				[ & ]( const Vector3 &a, const Vector3 &b, const Vector3 &c, index_t face ) {
+					(void)face;
+					Vector3 normal, closest;
+					real_t depth;
+					for (const Vector3 &tip : { local.start, local.end })
+					{
+						if (sphere_triangle_contact<_MESH::OneSided>( tip, local.radius, a, b, c, normal, depth, closest ))
+							keep( normal, depth, closest );
+					}
+
+					// the segment crossing the triangle has no closest points, it gets pushed along the face until the deeper end clears it
+					const Vector3 face_normal = (b - a).cross( c - a );
+					if (face_normal.length_squared() <= Epsilon * Epsilon)
+						return;
+
+					const Vector3 front = face_normal.normalized();
+					const real_t height_start = front.dot( local.start - a );
+					const real_t height_end = front.dot( local.end - a );
+					if (height_start * height_end <= 0 && height_start != height_end)
+					{
+						const Vector3 crossing = local.start + (local.end - local.start) * (height_start / (height_start - height_end));
+						bool inside = true;
+						for (index_t edge = 0; edge < 3 && inside; edge++)
+						{
+							const Vector3 &from = edge == 0 ? a : edge == 1 ? b : c;
+							const Vector3 &to = edge == 0 ? b : edge == 1 ? c : a;
+							inside = (to - from).cross( crossing - from ).dot( face_normal ) >= 0;
+						}
+
+						if (inside)
+						{
+							const real_t up = local.radius - std::min( height_start, height_end );
+							const real_t down = local.radius + std::max( height_start, height_end );
+							if (_MESH::OneSided || up <= down)
+								keep( front, up, crossing );
+							else
+								keep( -front, down, crossing );
+							return;
+						}
+					}
+
+					const TriangleCore triangle{ { a, b, c } };
+					const TMinkowski<Vector3, TCapsuleCore<Vector3>, TriangleCore> minkowski{ core, {}, triangle, {} };
+					TSimplex<Vector3> simplex{};
+					ContactCache cache{};
+					if (gjk( minkowski, cache, simplex ))
+						return;
+
+					const Vector3 gap = simplex.closest();
+					const real_t distance_squared = gap.length_squared();
+					if (distance_squared >= local.radius * local.radius)
+						return;
+
+					const real_t distance = std::sqrt( distance_squared );
+					keep( distance > 0 ? gap / distance : front, local.radius - distance, simplex.closest_on_a() - gap );
+				}
+			);
+
+			return manifold.point_count > 0;
+		}
+
+		// speculative contacts, the gap between shapes that don't touch yet makes a point with negative depth
+
+		// GJK's closest points of two convex shapes, overlapping shapes are the narrowphase's
+		template <typename _VEC, index_t _MAX_POINTS, typename _A, typename _B>
+		static bool separate_convex( const _A &shape_a, const _VEC &offset_a, const _B &shape_b, const _VEC &offset_b, real_t reach,
+																 ContactCache &cache, TManifold<_VEC, _MAX_POINTS> &manifold ) {
+			manifold.point_count = 0;
+
+			const TMinkowski<_VEC, _A, _B> minkowski{ shape_a, offset_a, shape_b, offset_b };
+			TSimplex<_VEC> simplex{};
+			if (gjk( minkowski, cache, simplex ))
+				return false;
+
+			const _VEC gap = simplex.closest();
+			const real_t distance_squared = gap.length_squared();
+			if (distance_squared >= reach * reach)
+				return false;
+
+			const real_t distance = std::sqrt( distance_squared );
+			manifold.normal = -gap / distance;
+			manifold.points[ manifold.point_count++ ] = { simplex.closest_on_a(), -distance };
+			return true;
+		}
+
+		// the shape's point nearest to the plane, only in front of it
+		template <typename _A>
+		static bool separate_plane( const _A &shape, const Vector3 &offset_a, const Plane &plane, const Vector3 &offset_b, real_t reach,
+																Manifold3D &manifold ) {
+			manifold.point_count = 0;
+			const Vector3 normal = plane.normal.normalized();
+			const Vector3 nearest = shape.support( -normal ) + offset_a - (plane.origin + offset_b);
+			const real_t gap = normal.dot( nearest );
+
+			if (gap <= 0 || gap >= reach)
+				return false;
+
+			Vector3 side, forward;
+			plane.get_axes( side, forward );
+			if (!is_above_plane( plane, side, forward, nearest ))
+				return false;
+
+			manifold.normal = -normal;
+			manifold.points[ manifold.point_count++ ] = { nearest + plane.origin + offset_b, -gap };
+			return true;
+		}
+
+		// the closest triangle within 'reach', one sided meshes only count what's in front of their triangles
+		template <typename _MESH, typename _A>
+		static bool separate_triangles( const _A &shape, const Vector3 &offset_a, const _MESH &mesh, const Vector3 &offset_b, real_t reach,
+																		Manifold3D &manifold ) {
+			manifold.point_count = 0;
+			const Vector3 offset = offset_a - offset_b;
+			AABB region = calculate_bounding_box( shape );
+			region.begin += offset;
+			region.end += offset;
+
+			real_t best = reach;
+			mesh.query_triangles(
+				region.expanded( reach ),
+				[ & ]( const Vector3 &a, const Vector3 &b, const Vector3 &c, index_t face ) {
+					(void)face;
+					const TriangleCore triangle{ { a, b, c } };
+					const TMinkowski<Vector3, _A, TriangleCore> minkowski{ shape, offset, triangle, {} };
+					TSimplex<Vector3> simplex{};
+					ContactCache cache{};
+					if (gjk( minkowski, cache, simplex ))
+						return;
+
+					const Vector3 gap = simplex.closest();
+					const real_t distance = gap.length();
+					if (distance >= best || (_MESH::OneSided && (b - a).cross( c - a ).dot( gap ) <= 0))
+						return;
+
+					best = distance;
+					manifold.normal = -gap / distance;
+					manifold.points[ 0 ] = { simplex.closest_on_a() + offset_b, -distance };
+					manifold.point_count = 1;
+				}
+			);
+
+			return manifold.point_count > 0;
+		}
+
+		// the shape types 'collide_convex' handles, with the getter for their data
+		template <typename ShapeType2D Type>
+		struct ConvexShape2D
+		{
+			static constexpr bool convex = false;
+		};
+
+		template <>
+		struct ConvexShape2D<ShapeType2D::Rectangle>
+		{
+			static constexpr bool convex = true;
+			inline static const Rect &get( const Shape2D &shape ) {
+				return shape.get_rectangle();
+			}
+		};
+
+		template <>
+		struct ConvexShape2D<ShapeType2D::Circle>
+		{
+			static constexpr bool convex = true;
+			inline static const Circle &get( const Shape2D &shape ) {
+				return shape.get_circle();
+			}
+		};
+
+		template <>
+		struct ConvexShape2D<ShapeType2D::Triangle>
+		{
+			static constexpr bool convex = true;
+			inline static const Triangle &get( const Shape2D &shape ) {
+				return shape.get_triangle();
+			}
+		};
+
+		template <>
+		struct ConvexShape2D<ShapeType2D::Polygon>
+		{
+			static constexpr bool convex = true;
+			inline static const Polygon2D &get( const Shape2D &shape ) {
+				return shape.get_polygon();
+			}
+		};
+
+		template <>
+		struct ConvexShape2D<ShapeType2D::Capsule>
+		{
+			static constexpr bool convex = true;
+			inline static const Capsule2D &get( const Shape2D &shape ) {
+				return shape.get_capsule();
+			}
+		};
+
+		template <typename ShapeType3D Type>
+		struct ConvexShape3D
+		{
+			static constexpr bool convex = false;
+		};
+
+		template <>
+		struct ConvexShape3D<ShapeType3D::Box>
+		{
+			static constexpr bool convex = true;
+			inline static const AABB &get( const Shape3D &shape ) {
+				return shape.get_box();
+			}
+		};
+
+		template <>
+		struct ConvexShape3D<ShapeType3D::Sphere>
+		{
+			static constexpr bool convex = true;
+			inline static const Sphere &get( const Shape3D &shape ) {
+				return shape.get_sphere();
+			}
+		};
+
+		template <>
+		struct ConvexShape3D<ShapeType3D::Pyramid>
+		{
+			static constexpr bool convex = true;
+			inline static const Pyramid &get( const Shape3D &shape ) {
+				return shape.get_pyramid();
+			}
+		};
+
+		template <>
+		struct ConvexShape3D<ShapeType3D::Capsule>
+		{
+			static constexpr bool convex = true;
+			inline static const Capsule3D &get( const Shape3D &shape ) {
+				return shape.get_capsule();
+			}
+		};
+
+		// any convex pair goes through GJK/EPA, specializations set 'implemented' for the pairs with a faster routine
+		// the dispatch table only points at implemented pairs (or at their swapped pair)
+		template<typename ShapeType2D ShapeTypeA, typename ShapeType2D ShapeTypeB>
+		struct Iterative2DImpl
+		{
+			static constexpr bool implemented = ConvexShape2D<ShapeTypeA>::convex && ConvexShape2D<ShapeTypeB>::convex;
+
+			inline static bool process( I2D::object_ref_pair objects, I2D::shape_ref_pair shapes, ContactCache &cache, Manifold2D &manifold ) {
+				return collide_convex(
+					ConvexShape2D<ShapeTypeA>::get( shapes.first ), objects.first.get_position(),
+					ConvexShape2D<ShapeTypeB>::get( shapes.second ), objects.second.get_position(),
+					cache, manifold
+				);
+			}
+		};
+
+		template<typename ShapeType3D ShapeTypeA, typename ShapeType3D ShapeTypeB>
+		struct Iterative3DImpl
+		{
+			static constexpr bool implemented = ConvexShape3D<ShapeTypeA>::convex && ConvexShape3D<ShapeTypeB>::convex;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				return collide_convex(
+					ConvexShape3D<ShapeTypeA>::get( shapes.first ), objects.first.get_position(),
+					ConvexShape3D<ShapeTypeB>::get( shapes.second ), objects.second.get_position(),
+					cache, manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative2DImpl<ShapeType2D::Circle, ShapeType2D::Circle>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I2D::object_ref_pair objects, I2D::shape_ref_pair shapes, ContactCache &cache, Manifold2D &manifold ) {
+				(void)cache;
+				manifold.point_count = 0;
+				const Vector2 center_a = shapes.first.get_circle().center + objects.first.get_position();
+				const Vector2 difference = shapes.second.get_circle().center + objects.second.get_position() - center_a;
+				const real_t radii = shapes.first.get_circle().radius + shapes.second.get_circle().radius;
+				const real_t distance_squared = difference.length_squared();
+
+				if (distance_squared >= radii * radii)
+				{
+					return false;
+				}
+
+				const real_t d = std::sqrt( distance_squared );
+				manifold.normal = d > 0 ? difference / d : Vector2{ 1, 0 };
+				manifold.points[ manifold.point_count++ ] = { center_a + manifold.normal * shapes.first.get_circle().radius, radii - d };
+				return true;
+			}
+		};
+
+		template<>
+		struct Iterative2DImpl<ShapeType2D::Polygon, ShapeType2D::Polygon>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I2D::object_ref_pair objects, I2D::shape_ref_pair shapes, ContactCache &cache, Manifold2D &manifold ) {
+				return collide_polygons(
+					shapes.first.get_polygon(), objects.first.get_position(),
+					shapes.second.get_polygon(), objects.second.get_position(),
+					cache, manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative2DImpl<ShapeType2D::Circle, ShapeType2D::Rectangle>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I2D::object_ref_pair objects, I2D::shape_ref_pair shapes, ContactCache &cache, Manifold2D &manifold ) {
+				(void)cache;
+				return collide_circle_rect(
+					shapes.first.get_circle(), objects.first.get_position(),
+					shapes.second.get_rectangle(), objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative2DImpl<ShapeType2D::Circle, ShapeType2D::Polygon>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I2D::object_ref_pair objects, I2D::shape_ref_pair shapes, ContactCache &cache, Manifold2D &manifold ) {
+				(void)cache;
+				return collide_circle_polygon(
+					shapes.first.get_circle(), objects.first.get_position(),
+					shapes.second.get_polygon(), objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		// the reverse pairs don't fall back on GJK, the table swaps them to the closed forms above
+		template<>
+		struct Iterative2DImpl<ShapeType2D::Rectangle, ShapeType2D::Circle>
+		{
+			static constexpr bool implemented = false;
+		};
+
+		template<>
+		struct Iterative2DImpl<ShapeType2D::Polygon, ShapeType2D::Circle>
+		{
+			static constexpr bool implemented = false;
+		};
+
+		// capsules against polygons measure the distance from their segment, the specializations below take the round shapes
+		template<typename ShapeType2D ShapeTypeB>
+		struct Iterative2DImpl<ShapeType2D::Capsule, ShapeTypeB>
+		{
+			static constexpr bool implemented = ConvexShape2D<ShapeTypeB>::convex;
+
+			inline static bool process( I2D::object_ref_pair objects, I2D::shape_ref_pair shapes, ContactCache &cache, Manifold2D &manifold ) {
+				return collide_capsule_convex(
+					shapes.first.get_capsule(), objects.first.get_position(),
+					ConvexShape2D<ShapeTypeB>::get( shapes.second ), objects.second.get_position(),
+					cache, manifold
+				);
+			}
+		};
+
+		template<typename ShapeType2D ShapeTypeA>
+		struct Iterative2DImpl<ShapeTypeA, ShapeType2D::Capsule>
+		{
+			static constexpr bool implemented = false;
+		};
+
+		template<>
+		struct Iterative2DImpl<ShapeType2D::Capsule, ShapeType2D::Circle>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I2D::object_ref_pair objects, I2D::shape_ref_pair shapes, ContactCache &cache, Manifold2D &manifold ) {
+				(void)cache;
+				return collide_capsule_round(
+					shapes.first.get_capsule(), objects.first.get_position(),
+					shapes.second.get_circle(), objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative2DImpl<ShapeType2D::Capsule, ShapeType2D::Capsule>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I2D::object_ref_pair objects, I2D::shape_ref_pair shapes, ContactCache &cache, Manifold2D &manifold ) {
+				(void)cache;
+				return collide_capsules(
+					shapes.first.get_capsule(), objects.first.get_position(),
+					shapes.second.get_capsule(), objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative2DImpl<ShapeType2D::Capsule, ShapeType2D::Ray>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I2D::object_ref_pair objects, I2D::shape_ref_pair shapes, ContactCache &cache, Manifold2D &manifold ) {
+				(void)cache;
+				return collide_capsule_ray(
+					shapes.first.get_capsule(), objects.first.get_position(),
+					shapes.second.get_ray(), objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Sphere, ShapeType3D::Sphere>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				return collide_spheres(
+					shapes.first.get_sphere(), objects.first.get_position(),
+					shapes.second.get_sphere(), objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Sphere, ShapeType3D::Box>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				return collide_sphere_box(
+					shapes.first.get_sphere(), objects.first.get_position(),
+					shapes.second.get_box(), objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Box, ShapeType3D::Box>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				return collide_boxes(
+					shapes.first.get_box(), objects.first.get_position(),
+					shapes.second.get_box(), objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Sphere, ShapeType3D::Plane>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				return collide_sphere_plane(
+					shapes.first.get_sphere(), objects.first.get_position(),
+					shapes.second.get_plane(), objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Box, ShapeType3D::Plane>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				return collide_box_plane(
+					shapes.first.get_box(), objects.first.get_position(),
+					shapes.second.get_plane(), objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Sphere, ShapeType3D::Mesh>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				const std::shared_ptr<const TriangleMesh> &mesh = shapes.second.get_mesh();
+				return mesh && collide_sphere_triangles(
+					shapes.first.get_sphere(), objects.first.get_position(),
+					*mesh, objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Box, ShapeType3D::Mesh>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				const std::shared_ptr<const TriangleMesh> &mesh = shapes.second.get_mesh();
+				return mesh && collide_box_triangles(
+					shapes.first.get_box(), objects.first.get_position(),
+					*mesh, objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Sphere, ShapeType3D::HeightField>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				const std::shared_ptr<const HeightField> &height_field = shapes.second.get_height_field();
+				return height_field && collide_sphere_triangles(
+					shapes.first.get_sphere(), objects.first.get_position(),
+					*height_field, objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Box, ShapeType3D::HeightField>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				const std::shared_ptr<const HeightField> &height_field = shapes.second.get_height_field();
+				return height_field && collide_box_triangles(
+					shapes.first.get_box(), objects.first.get_position(),
+					*height_field, objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Box, ShapeType3D::Sphere>
+		{
+			static constexpr bool implemented = false;
+		};
+
+		template<typename ShapeType3D ShapeTypeB>
+		struct Iterative3DImpl<ShapeType3D::Capsule, ShapeTypeB>
+		{
+			static constexpr bool implemented = ConvexShape3D<ShapeTypeB>::convex;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				return collide_capsule_convex(
+					shapes.first.get_capsule(), objects.first.get_position(),
+					ConvexShape3D<ShapeTypeB>::get( shapes.second ), objects.second.get_position(),
+					cache, manifold
+				);
+			}
+		};
+
+		template<typename ShapeType3D ShapeTypeA>
+		struct Iterative3DImpl<ShapeTypeA, ShapeType3D::Capsule>
+		{
+			static constexpr bool implemented = false;
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Capsule, ShapeType3D::Sphere>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				return collide_capsule_round(
+					shapes.first.get_capsule(), objects.first.get_position(),
+					shapes.second.get_sphere(), objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Capsule, ShapeType3D::Capsule>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				return collide_capsules(
+					shapes.first.get_capsule(), objects.first.get_position(),
+					shapes.second.get_capsule(), objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Capsule, ShapeType3D::Ray>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				return collide_capsule_ray(
+					shapes.first.get_capsule(), objects.first.get_position(),
+					shapes.second.get_ray(), objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Capsule, ShapeType3D::Plane>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				return collide_capsule_plane(
+					shapes.first.get_capsule(), objects.first.get_position(),
+					shapes.second.get_plane(), objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Capsule, ShapeType3D::Mesh>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				const std::shared_ptr<const TriangleMesh> &mesh = shapes.second.get_mesh();
+				return mesh && collide_capsule_triangles(
+					shapes.first.get_capsule(), objects.first.get_position(),
+					*mesh, objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		template<>
+		struct Iterative3DImpl<ShapeType3D::Capsule, ShapeType3D::HeightField>
+		{
+			static constexpr bool implemented = true;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				const std::shared_ptr<const HeightField> &height_field = shapes.second.get_height_field();
+				return height_field && collide_capsule_triangles(
+					shapes.first.get_capsule(), objects.first.get_position(),
+					*height_field, objects.second.get_position(),
+					manifold
+				);
+			}
+		};
+
+		// speculative routines, any convex pair and the convex shapes against the static geometry
+		template<typename ShapeType2D ShapeTypeA, typename ShapeType2D ShapeTypeB>
+		struct Separation2DImpl
+		{
+			static constexpr bool implemented = ConvexShape2D<ShapeTypeA>::convex && ConvexShape2D<ShapeTypeB>::convex;
+
+			inline static bool process( I2D::object_ref_pair objects, I2D::shape_ref_pair shapes, real_t reach, ContactCache &cache, Manifold2D &manifold ) {
+				return separate_convex(
+					ConvexShape2D<ShapeTypeA>::get( shapes.first ), objects.first.get_position(),
+					ConvexShape2D<ShapeTypeB>::get( shapes.second ), objects.second.get_position(),
+					reach, cache, manifold
+				);
+			}
+		};
+
+		template<typename ShapeType3D ShapeTypeA, typename ShapeType3D ShapeTypeB>
+		struct Separation3DImpl
+		{
+			static constexpr bool implemented = ConvexShape3D<ShapeTypeA>::convex && ConvexShape3D<ShapeTypeB>::convex;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, real_t reach, ContactCache &cache, Manifold3D &manifold ) {
+				return separate_convex(
+					ConvexShape3D<ShapeTypeA>::get( shapes.first ), objects.first.get_position(),
+					ConvexShape3D<ShapeTypeB>::get( shapes.second ), objects.second.get_position(),
+					reach, cache, manifold
+				);
+			}
+		};
+
+		template<typename ShapeType3D ShapeTypeA>
+		struct Separation3DImpl<ShapeTypeA, ShapeType3D::Plane>
+		{
+			static constexpr bool implemented = ConvexShape3D<ShapeTypeA>::convex;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, real_t reach, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				return separate_plane(
+					ConvexShape3D<ShapeTypeA>::get( shapes.first ), objects.first.get_position(),
+					shapes.second.get_plane(), objects.second.get_position(),
+					reach, manifold
+				);
+			}
+		};
+
+		template<typename ShapeType3D ShapeTypeA>
+		struct Separation3DImpl<ShapeTypeA, ShapeType3D::Mesh>
+		{
+			static constexpr bool implemented = ConvexShape3D<ShapeTypeA>::convex;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, real_t reach, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				const std::shared_ptr<const TriangleMesh> &mesh = shapes.second.get_mesh();
+				return mesh && separate_triangles(
+					ConvexShape3D<ShapeTypeA>::get( shapes.first ), objects.first.get_position(),
+					*mesh, objects.second.get_position(),
+					reach, manifold
+				);
+			}
+		};
+
+		template<typename ShapeType3D ShapeTypeA>
+		struct Separation3DImpl<ShapeTypeA, ShapeType3D::HeightField>
+		{
+			static constexpr bool implemented = ConvexShape3D<ShapeTypeA>::convex;
+
+			inline static bool process( I3D::object_ref_pair objects, I3D::shape_ref_pair shapes, real_t reach, ContactCache &cache, Manifold3D &manifold ) {
+				(void)cache;
+				const std::shared_ptr<const HeightField> &height_field = shapes.second.get_height_field();
+				return height_field && separate_triangles(
+					ConvexShape3D<ShapeTypeA>::get( shapes.first ), objects.first.get_position(),
+					*height_field, objects.second.get_position(),
+					reach, manifold
+				);
+			}
+		};
+
+		template<>
+		template<typename I2D::shape_type_enum ShapeTypeA, typename I2D::shape_type_enum ShapeTypeB>
+		inline bool I2D::solve( object_ref_pair objects, shape_ref_pair shapes, ContactCache &cache, manifold_type &manifold ) {
+			return Iterative2DImpl<ShapeTypeA, ShapeTypeB>::process( objects, shapes, cache, manifold );
+		}
+
+		template<>
+		template<typename I2D::shape_type_enum ShapeTypeA, typename I2D::shape_type_enum ShapeTypeB>
+		inline constexpr bool I2D::is_implemented() {
+			return Iterative2DImpl<ShapeTypeA, ShapeTypeB>::implemented;
+		}
+
+		template<>
+		template<typename I3D::shape_type_enum ShapeTypeA, typename I3D::shape_type_enum ShapeTypeB>
+		inline bool I3D::solve( object_ref_pair objects, shape_ref_pair shapes, ContactCache &cache, manifold_type &manifold ) {
+			return Iterative3DImpl<ShapeTypeA, ShapeTypeB>::process( objects, shapes, cache, manifold );
+		}
+
+		template<>
+		template<typename I3D::shape_type_enum ShapeTypeA, typename I3D::shape_type_enum ShapeTypeB>
+		inline constexpr bool I3D::is_implemented() {
+			return Iterative3DImpl<ShapeTypeA, ShapeTypeB>::implemented;
+		}
+
+		template<>
+		template<typename I2D::shape_type_enum ShapeTypeA, typename I2D::shape_type_enum ShapeTypeB>
+		inline bool I2D::separate( object_ref_pair objects, shape_ref_pair shapes, real_t reach, ContactCache &cache, manifold_type &manifold ) {
+			return Separation2DImpl<ShapeTypeA, ShapeTypeB>::process( objects, shapes, reach, cache, manifold );
+		}
+
+		template<>
+		template<typename I2D::shape_type_enum ShapeTypeA, typename I2D::shape_type_enum ShapeTypeB>
+		inline constexpr bool I2D::is_separable() {
+			return Separation2DImpl<ShapeTypeA, ShapeTypeB>::implemented;
+		}
+
+		template<>
+		template<typename I3D::shape_type_enum ShapeTypeA, typename I3D::shape_type_enum ShapeTypeB>
+		inline bool I3D::separate( object_ref_pair objects, shape_ref_pair shapes, real_t reach, ContactCache &cache, manifold_type &manifold ) {
+			return Separation3DImpl<ShapeTypeA, ShapeTypeB>::process( objects, shapes, reach, cache, manifold );
+		}
+
+		template<>
+		template<typename I3D::shape_type_enum ShapeTypeA, typename I3D::shape_type_enum ShapeTypeB>
+		inline constexpr bool I3D::is_separable() {
+			return Separation3DImpl<ShapeTypeA, ShapeTypeB>::implemented;
+		}
+
+		// the table's entries, solve with the arguments swapped and the fallback for pairs with no routine
+		template <typename _SOLVER, typename _SOLVER::shape_type_enum ShapeTypeA, typename _SOLVER::shape_type_enum ShapeTypeB>
+		inline static bool solve_swapped( typename _SOLVER::object_ref_pair objects, typename _SOLVER::shape_ref_pair shapes, ContactCache &cache,
+																			typename _SOLVER::manifold_type &manifold ) {
+			// the cached axis owner is relative to the argument order
+			const auto swap_owner = []( ContactCache &swapped ) {
+				if (swapped.axis_owner != ContactCache::NoFeature)
+					swapped.axis_owner ^= 1;
+			};
+
+			swap_owner( cache );
+			const bool result = _SOLVER::template solve<ShapeTypeB, ShapeTypeA>( { objects.second, objects.first }, { shapes.second, shapes.first }, cache, manifold );
+			swap_owner( cache );
+
+			// the points are in world space, only the normal depends on the order
+			manifold.normal = -manifold.normal;
+			return result;
+		}
+
+		template <typename _SOLVER>
+		inline static bool solve_none( typename _SOLVER::object_ref_pair objects, typename _SOLVER::shape_ref_pair shapes, ContactCache &cache,
+																	 typename _SOLVER::manifold_type &manifold ) {
+			(void)objects;
+			(void)shapes;
+			(void)cache;
+			manifold.point_count = 0;
+			return false;
+		}
+
+		// row 'a', column 'b' holds the routine for shape type 'a' against shape type 'b'
+		template <typename _SOLVER>
+		struct SolverTable
+		{
+			using shape_type_enum = typename _SOLVER::shape_type_enum;
+			using SolverProc = typename _SOLVER::SolverProc;
+			static constexpr index_t Count = _SOLVER::ShapeTypeCount;
+
+			template <index_t Index>
+			static constexpr SolverProc make_entry() {
+				constexpr shape_type_enum type_a = static_cast<shape_type_enum>(Index / Count);
+				constexpr shape_type_enum type_b = static_cast<shape_type_enum>(Index % Count);
+
+				if constexpr (_SOLVER::template is_implemented<type_a, type_b>())
+					return &_SOLVER::template solve<type_a, type_b>;
+				else if constexpr (_SOLVER::template is_implemented<type_b, type_a>())
+					return &solve_swapped<_SOLVER, type_a, type_b>;
+				else
+					return &solve_none<_SOLVER>;
+			}
+
+			template <index_t... Indices>
+			static constexpr std::array<SolverProc, Count * Count> make( std::index_sequence<Indices...> ) {
+				return { make_entry<Indices>()... };
+			}
+
+			static constexpr std::array<SolverProc, Count * Count> entries = make( std::make_index_sequence<Count * Count>() );
+		};
+
+		template<typename _OBJ>
+		inline typename TIterative<_OBJ>::SolverProc TIterative<_OBJ>::get_solver( shape_type_enum type_a, shape_type_enum type_b ) {
+			return SolverTable<TIterative<_OBJ>>::entries[ static_cast<index_t>(type_a) * ShapeTypeCount + static_cast<index_t>(type_b) ];
+		}
+
+		// the same as the solver table's entries for 'separate'
+		template <typename _SOLVER, typename _SOLVER::shape_type_enum ShapeTypeA, typename _SOLVER::shape_type_enum ShapeTypeB>
+		inline static bool separate_swapped( typename _SOLVER::object_ref_pair objects, typename _SOLVER::shape_ref_pair shapes, real_t reach,
+																				 ContactCache &cache, typename _SOLVER::manifold_type &manifold ) {
+			const bool result = _SOLVER::template separate<ShapeTypeB, ShapeTypeA>( { objects.second, objects.first }, { shapes.second, shapes.first }, reach, cache, manifold );
+			manifold.normal = -manifold.normal;
+			return result;
+		}
+
+		template <typename _SOLVER>
+		inline static bool separate_none( typename _SOLVER::object_ref_pair objects, typename _SOLVER::shape_ref_pair shapes, real_t reach,
+																			ContactCache &cache, typename _SOLVER::manifold_type &manifold ) {
+			(void)objects;
+			(void)shapes;
+			(void)reach;
+			(void)cache;
+			manifold.point_count = 0;
+			return false;
+		}
+
+		template <typename _SOLVER>
+		struct SeparationTable
+		{
+			using shape_type_enum = typename _SOLVER::shape_type_enum;
+			using SeparationProc = typename _SOLVER::SeparationProc;
+			static constexpr index_t Count = _SOLVER::ShapeTypeCount;
+
+			template <index_t Index>
+			static constexpr SeparationProc make_entry() {
+				constexpr shape_type_enum type_a = static_cast<shape_type_enum>(Index / Count);
+				constexpr shape_type_enum type_b = static_cast<shape_type_enum>(Index % Count);
+
+				if constexpr (_SOLVER::template is_separable<type_a, type_b>())
+					return &_SOLVER::template separate<type_a, type_b>;
+				else if constexpr (_SOLVER::template is_separable<type_b, type_a>())
+					return &separate_swapped<_SOLVER, type_a, type_b>;
+				else
+					return &separate_none<_SOLVER>;
+			}
+
+			template <index_t... Indices>
+			static constexpr std::array<SeparationProc, Count * Count> make( std::index_sequence<Indices...> ) {
+				return { make_entry<Indices>()... };
+			}
+
+			static constexpr std::array<SeparationProc, Count * Count> entries = make( std::make_index_sequence<Count * Count>() );
+		};
+
+		template<typename _OBJ>
+		inline typename TIterative<_OBJ>::SeparationProc TIterative<_OBJ>::get_separation( shape_type_enum type_a, shape_type_enum type_b ) {
+			return SeparationTable<TIterative<_OBJ>>::entries[ static_cast<index_t>(type_a) * ShapeTypeCount + static_cast<index_t>(type_b) ];
+		}
+	}
+#pragma endregion
+
+	template<typename _VEC>
+	void TPolygon<_VEC>::recalculate() {
+		m_dirty = false;
+		if (m_points.size() < 3)
+		{
+			m_winding = Winding::None;
+
+		}
+		else
+		{
+			m_winding =
+				is_clockwise( m_points.data(), m_points.size() ) ? Winding::Clockwise : Winding::CounterClockwise;
+		}
+
+		m_center = {};
+
+		if (m_points.empty())
+			return;
+
+		m_bounds = { m_points[ 0 ], m_points[ 0 ] };
+
+
+		for (index_t i = 0; i < m_points.size(); i++)
+		{
+			m_center += m_points[ i ];
+			m_bounds.encase( m_points[ i ] );
+		}
+		m_center /= static_cast<real_t>(m_points.size());
+
+		// outward edge normals, the winding decides which side is out
+		m_normals.clear();
+		if constexpr (std::is_same_v<vector_type, Vector2>)
+		{
+			if (m_points.size() < 3)
+				return;
+
+			real_t doubled_area = 0;
+			for (index_t i = 0; i < m_points.size(); i++)
+			{
+				const Vector2 &point = m_points[ i ];
+				const Vector2 &next = m_points[ (i + 1) % m_points.size() ];
+				doubled_area += point.x * next.y - point.y * next.x;
+			}
+
+			m_normals.reserve( m_points.size() );
+			for (index_t i = 0; i < m_points.size(); i++)
+			{
+				const Vector2 edge = m_points[ (i + 1) % m_points.size() ] - m_points[ i ];
+				const Vector2 normal = doubled_area > 0 ? Vector2{ edge.y, -edge.x } : Vector2{ -edge.y, edge.x };
+				m_normals.push_back( normal.normalized() );
+			}
+		}
+	}
+
+	template<typename _STATE>
+	TObject<_STATE>::TObject( ObjectType type )
+		: m_type{ type }, m_flags{ ObjFlag_None }, m_awake{ true }, m_active{ true },
+		m_position{}, m_angle{}, m_linear_velocity{}, m_angular_velocity{}, m_mass{ 1 }, m_friction{ 0.5f }, m_restitution{}, m_mask{ ~CollisionMask() },
+		m_frame{}, m_sweep{}, m_shapes{} {
+
+	}
+
+	template<typename _STATE>
+	void TObject<_STATE>::set_position( const vector_type &value ) {
+		m_position = value;
+		m_frame_dirty = true;
+		wakeup();
+	}
+
+	template<typename _STATE>
+	void TObject<_STATE>::set_sweep( const vector_type &displacement ) {
+		if (displacement == m_sweep)
+			return;
+
+		m_sweep = displacement;
+		m_frame_dirty = true;
+	}
+
+	template<typename _STATE>
+	void TObject<_STATE>::set_angle( real_t value ) {
+		m_angle = value;
+		wakeup();
+	}
+
+	template<typename _STATE>
+	void TObject<_STATE>::set_angular_velocity( real_t value ) {
+		m_angular_velocity = value;
+		wakeup();
+	}
+
+	template<typename _STATE>
+	void TObject<_STATE>::set_linear_velocity( const vector_type &value ) {
+		m_linear_velocity = value;
+		wakeup();
+	}
+
+	template<typename _STATE>
+	void TObject<_STATE>::set_mass( real_t value ) {
+		m_mass = value;
+		wakeup();
+	}
+
+	template<typename _STATE>
+	void TObject<_STATE>::set_friction( real_t value ) {
+		m_friction = value;
+		wakeup();
+	}
+
+	template<typename _STATE>
+	void TObject<_STATE>::set_restitution( real_t value ) {
+		m_restitution = value;
+		wakeup();
+	}
+
+	template<typename _STATE>
+	void TObject<_STATE>::set_mask( const CollisionMask mask ) {
+		m_mask = mask;
+		wakeup();
+	}
+
+	template<typename _STATE>
+	void TObject<_STATE>::set_shape( const shape_type &shape ) {
+		set_shape( shape, 0 );
+	}
+
+	template<typename _STATE>
+	void TObject<_STATE>::set_shape( const shape_type &shape, index_t index ) {
+		m_shapes[ index ] = shape;
+		m_shapes[ index ].recalculate_bounding_box();
+		invalidate_frame();
+		wakeup();
+	}
+
+	template<typename _STATE>
+	void TObject<_STATE>::add_shape( const shape_type &shape ) {
+		m_shapes.push_back( shape );
+		invalidate_frame();
+		wakeup();
+	}
+
+	template<typename _STATE>
+	void TObject<_STATE>::remove_shape( index_t index ) {
 		m_shapes.erase( m_shapes.begin() + index );
+		invalidate_frame();
 		wakeup();
 	}
 
-	template<typename _STATE>
-	void TObject<_STATE>::recalculate_frame() {
-		m_frame_dirty = false;
-		m_frame = {};
-		for (shape_type &shape : m_shapes)
-		{
-			shape.recalculate_bounding_box();
-			m_frame.encase( shape.get_bounding_box() );
+	template<typename _STATE>
+	void TObject<_STATE>::recalculate_frame() {
+		m_frame_dirty = false;
+		m_frame = { m_position, m_position };
+
+		for (index_t i = 0; i < m_shapes.size(); i++)
+		{
+			m_shapes[ i ].recalculate_bounding_box();
+
+			// shape boxes are local to the object
+			frame_type shape_frame = m_shapes[ i ].get_bounding_box();
+			shape_frame.begin += m_position;
+			shape_frame.end += m_position;
+
+			if (i == 0)
+				m_frame = shape_frame;
+			else
+				m_frame.encase( shape_frame );
+		}
+
+		if (m_sweep != vector_type{})
+		{
+			frame_type swept = m_frame;
+			swept.begin += m_sweep;
+			swept.end += m_sweep;
+			m_frame.encase( swept );
+		}
+
+		if (m_shape_tree_dirty)
+		{
+			m_shape_tree_dirty = false;
+			if (m_shapes.size() < TShapeTree<frame_type>::MinimumShapes)
+			{
+				m_shape_tree.clear();
+				return;
+			}
+
+			std::vector<frame_type> frames( m_shapes.size() );
+			for (index_t i = 0; i < m_shapes.size(); i++)
+			{
+				frames[ i ] = m_shapes[ i ].get_bounding_box();
+			}
+			m_shape_tree.build( frames );
+		}
+	}
+
+	template<typename _FRAME>
+	void TShapeTree<_FRAME>::build( const std::vector<frame_type> &frames ) {
+		clear();
+		if (frames.empty())
+			return;
+
+		m_shapes.resize( frames.size() );
+		for (index_t i = 0; i < frames.size(); i++)
+		{
+			m_shapes[ i ] = i;
+		}
+
+		m_nodes.reserve( frames.size() * 2 );
+		m_nodes.push_back( {} );
+		build_node( 0, frames, 0, frames.size(), 0 );
+	}
+
+	template<typename _FRAME>
+	void TShapeTree<_FRAME>::build_node( index_t node, const std::vector<frame_type> &frames, index_t begin, index_t end, index_t depth ) {
+		constexpr index_t leaf_size = 2;
+
+		frame_type frame = frames[ m_shapes[ begin ] ];
+		frame_type centers{ (frame.begin + frame.end) * real_t( 0.5 ), (frame.begin + frame.end) * real_t( 0.5 ) };
+		for (index_t i = begin + 1; i < end; i++)
+		{
+			const frame_type &shape_frame = frames[ m_shapes[ i ] ];
+			frame.encase( shape_frame );
+			centers.encase( (shape_frame.begin + shape_frame.end) * real_t( 0.5 ) );
+		}
+
+		m_nodes[ node ].frame = frame;
+
+		// the query stacks only fit 'MaxDepth' levels, median splits never get there but a leaf is always safe
+		if (end - begin <= leaf_size || depth == MaxDepth)
+		{
+			m_nodes[ node ].first = begin;
+			m_nodes[ node ].count = end - begin;
+			return;
+		}
+
+		index_t axis = 0;
+		for (index_t i = 1; i < frame_type::dimensions; i++)
+		{
+			if ((&centers.end.x)[ i ] - (&centers.begin.x)[ i ] > (&centers.end.x)[ axis ] - (&centers.begin.x)[ axis ])
+				axis = i;
+		}
+
+		const index_t middle = begin + (end - begin) / 2;
+		std::nth_element(
+			m_shapes.begin() + begin, m_shapes.begin() + middle, m_shapes.begin() + end,
+			[ &frames, axis ]( const index_t left, const index_t right ) {
+				return (&frames[ left ].begin.x)[ axis ] + (&frames[ left ].end.x)[ axis ]
+					< (&frames[ right ].begin.x)[ axis ] + (&frames[ right ].end.x)[ axis ];
+			}
+		);
+
+		const index_t children = m_nodes.size();
+		m_nodes[ node ].first = children;
+		m_nodes[ node ].count = 0;
+		m_nodes.push_back( {} );
+		m_nodes.push_back( {} );
+		build_node( children, frames, begin, middle, depth + 1 );
+		build_node( children + 1, frames, middle, end, depth + 1 );
+	}
+
+	// batchers that only look at the objects the space tells them moved
+	template <typename _BATCHER, typename = void>
+	struct tracks_moves : std::false_type
+	{
+	};
+
+	template <typename _BATCHER>
+	struct tracks_moves<_BATCHER, std::void_t<decltype(std::declval<_BATCHER &>().mark_moved( index_t() ))>> : std::true_type
+	{
+	};
+
+	// batchers that bucket objects by their layers themselves
+	template <typename _BATCHER, typename = void>
+	struct has_layers : std::false_type
+	{
+	};
+
+	template <typename _BATCHER>
+	struct has_layers<_BATCHER, std::void_t<decltype(std::declval<_BATCHER &>().set_layer_matrix( std::declval<const LayerMatrix &>() ))>> : std::true_type
+	{
+	};
+
+	template<typename _OBJ, typename _BATCHER>
+	TSpace<_OBJ, _BATCHER>::TSpace() : m_dt{}, m_static_tree{ 0 } {
+		m_layer_matrix.fill( ~CollisionMask() );
+		if constexpr (has_layers<batcher_type>::value)
+			m_batcher.set_layer_matrix( m_layer_matrix );
+	}
+
+	template<typename _OBJ, typename _BATCHER>
+	void TSpace<_OBJ, _BATCHER>::update( real_t deltatime ) {
+		if (deltatime - Epsilon <= 0)
+			deltatime = Epsilon;
+
+		m_dt = deltatime;
+
+		/*
+		- Do we need to recalculate the collision image (BatchResult) per iteration or per frame?
+		+ currently it is per frame
+
+		- Should each impulse be less effective?
+		+ idk
+		*/
+		//constexpr solvers::I2D::SolverProc xx = solvers::I2D::solve<object_type::shape_type_enum::None, object_type::shape_type_enum::None>;
+
+		// preprocessor, every object only touches its own frame, reach and solver state
+		m_reach.resize( m_objects.size() );
+		m_velocities.resize( m_objects.size() );
+		m_pseudo_velocities.assign( m_objects.size(), {} );
+		m_inverse_masses.resize( m_objects.size() );
+		const size_t chunk = batchers::parallel_chunk( m_objects.size(), m_thread_pool );
+		m_chunks.resize( batchers::parallel_chunk_count( m_objects.size(), chunk ) );
+		for (PairChunk &scratch : m_chunks)
+		{
+			scratch.moved.clear();
+		}
+
+		batchers::parallel_for(
+			m_objects.size(), m_thread_pool,
+			[ this, chunk ]( const size_t begin, const size_t end ) {
+				ObjectBatch &moved = m_chunks[ begin / chunk ].moved;
+
+				for (size_t i = begin; i < end; i++)
+				{
+					const object_type &obj = m_objects[ i ];
+
+					// statics never move, the rest reach over what they'll pass this step
+					if (obj.get_type() != ObjectType::Static)
+						m_objects[ i ].set_sweep( m_speculative ? obj.get_linear_velocity() * m_dt : typename object_type::vector_type{} );
+
+					if constexpr (tracks_moves<batcher_type>::value)
+					{
+						if (m_batcher.needs_update( i, obj ))
+							moved.push_back( i );
+					}
+
+					if (obj.is_frame_dirty())
+						m_objects[ i ].recalculate_frame();
+
+					m_reach[ i ] = get_reach( obj.get_mask() );
+					m_velocities[ i ] = obj.get_linear_velocity();
+					m_inverse_masses[ i ] = obj.get_type() == ObjectType::Static || obj.get_mass() <= 0 ? 0 : 1 / obj.get_mass();
+				}
+			}
+		);
+
+		// chunk order keeps the queue in index order
+		if constexpr (tracks_moves<batcher_type>::value)
+		{
+			for (const PairChunk &scratch : m_chunks)
+			{
+				for (const index_t index : scratch.moved)
+				{
+					m_batcher.mark_moved( index );
+				}
+			}
+		}
+
+		m_batcher.try_rebuild( m_objects );
+		collect_pairs();
+		m_pair_cache.update( m_pairs );
+		build_islands();
+
+		for (index_t island = 0; island < m_islands.size(); island++)
+		{
+			collide_island( island );
+			solve_island( island );
+		}
+
+		// writes the solved velocities back and moves everything that isn't static
+		batchers::parallel_for(
+			m_objects.size(), m_thread_pool,
+			[ this ]( const size_t begin, const size_t end ) {
+				for (size_t i = begin; i < end; i++)
+				{
+					object_type &obj = m_objects[ i ];
+					if (!obj.is_activated() || obj.get_type() == ObjectType::Static)
+						continue;
+
+					if (m_velocities[ i ] != obj.get_linear_velocity())
+						obj.set_linear_velocity( m_velocities[ i ] );
+
+					const typename object_type::vector_type motion = m_velocities[ i ] + m_pseudo_velocities[ i ];
+					if (motion.length_squared() > 0)
+						obj.set_position( obj.get_position() + motion * m_dt );
+				}
+			}
+		);
+	}
+
+	// broadphases that already enumerate their pairs, the rest only give batches
+	template <typename _BATCHER, typename = void>
+	struct has_pairs : std::false_type
+	{
+	};
+
+	template <typename _BATCHER>
+	struct has_pairs<_BATCHER, std::void_t<decltype(std::declval<const _BATCHER &>().get_pairs())>> : std::true_type
+	{
+	};
+
+	// batchers that can run their rebuilds on a thread pool
+	template <typename _BATCHER, typename = void>
+	struct has_thread_pool : std::false_type
+	{
+	};
+
+	template <typename _BATCHER>
+	struct has_thread_pool<_BATCHER, std::void_t<decltype(std::declval<_BATCHER &>().set_thread_pool( nullptr ))>> : std::true_type
+	{
+	};
+
+	template<typename _OBJ, typename _BATCHER>
+	void TSpace<_OBJ, _BATCHER>::set_thread_pool( IThreadPool *pool ) {
+		m_thread_pool = pool;
+
+		if constexpr (has_thread_pool<batcher_type>::value)
+			m_batcher.set_thread_pool( pool );
+	}
+
+	template<typename _OBJ, typename _BATCHER>
+	void TSpace<_OBJ, _BATCHER>::set_layers_interact( index_t layer_a, index_t layer_b, bool interact ) {
+		// the shifts below are undefined past the mask's width
+		if (layer_a >= LayerCount || layer_b >= LayerCount)
+			return;
+
+		if (interact)
+		{
+			m_layer_matrix[ layer_a ] |= CollisionMask( 1 ) << layer_b;
+			m_layer_matrix[ layer_b ] |= CollisionMask( 1 ) << layer_a;
+		}
+		else
+		{
+			m_layer_matrix[ layer_a ] &= ~(CollisionMask( 1 ) << layer_b);
+			m_layer_matrix[ layer_b ] &= ~(CollisionMask( 1 ) << layer_a);
+		}
+
+		if constexpr (has_layers<batcher_type>::value)
+			m_batcher.set_layer_matrix( m_layer_matrix );
+	}
+
+	template<typename _OBJ, typename _BATCHER>
+	void TSpace<_OBJ, _BATCHER>::set_speculative_contacts( bool enabled ) {
+		m_speculative = enabled;
+	}
+
+	template<typename _OBJ, typename _BATCHER>
+	void TSpace<_OBJ, _BATCHER>::set_wide_solver( bool enabled ) {
+		m_wide_solver = enabled;
+	}
+
+	template<typename _OBJ, typename _BATCHER>
+	void TSpace<_OBJ, _BATCHER>::collect_pairs() {
+		m_pairs.clear();
+
+		const auto add_pair = [ this ]( const index_t index_a, const index_t index_b ) {
+			const object_type &object_a = m_objects[ index_a ];
+			const object_type &object_b = m_objects[ index_b ];
+
+			if (object_a.get_type() == ObjectType::Static && object_b.get_type() == ObjectType::Static)
+				return;
+
+			// the layers never meet, not worth a frame test; layered batchers never report those
+			if constexpr (!has_layers<batcher_type>::value)
+			{
+				if (!(m_reach[ index_a ] & object_b.get_mask()))
+					return;
+			}
+
+			// bounding boxes not intersecting, objects can't be colliding
+			if (!object_a.get_frame().intersects( object_b.get_frame() ))
+				return;
+
+			m_pairs.emplace_back( std::min( index_a, index_b ), std::max( index_a, index_b ) );
+		};
+
+		if constexpr (has_pairs<batcher_type>::value)
+		{
+			for (const ObjectPair &pair : m_batcher.get_pairs())
+			{
+				add_pair( pair.first, pair.second );
+			}
+		}
+		else
+		{
+			// batches are independent, each chunk of them gets its own scratch
+			const BatchResult &batches = m_batcher.get_results();
+			const size_t chunk = batchers::parallel_chunk( batches.size(), m_thread_pool );
+			m_chunks.resize( batchers::parallel_chunk_count( batches.size(), chunk ) );
+
+			batchers::parallel_for(
+				batches.size(), m_thread_pool,
+				[ this, &batches, chunk ]( const size_t begin, const size_t end ) {
+					PairChunk &scratch = m_chunks[ begin / chunk ];
+					scratch.pairs.clear();
+
+					for (size_t k = begin; k < end; k++)
+					{
+						// the batcher keeps one run per layer bucket, run pairs whose layers never meet are skipped whole
+						const ObjectBatch &batch = batches[ k ];
+						const std::vector<batchers::BucketRun> &runs = m_batcher.get_runs( k );
+						const batchers::LayerBuckets &buckets = m_batcher.get_buckets();
+
+						scratch.frames.resize( batch.size() );
+						for (index_t i = 0; i < batch.size(); i++)
+						{
+							scratch.frames.set( i, m_objects[ batch[ i ] ].get_frame() );
+						}
+
+						for (index_t run_a = 0; run_a < runs.size(); run_a++)
+						{
+							for (index_t run_b = run_a; run_b < runs.size(); run_b++)
+							{
+								const batchers::BucketRun &runs_a = runs[ run_a ];
+								const batchers::BucketRun &runs_b = runs[ run_b ];
+
+								// the matrix is symmetric, one side is enough
+								if (!buckets.meet( runs_a.bucket, runs_b.bucket ))
+									continue;
+
+								for (index_t i = runs_a.begin; i < runs_a.end; i++)
+								{
+									scratch.frames.for_each_overlap(
+										m_objects[ batch[ i ] ].get_frame(), run_a == run_b ? i + 1 : runs_b.begin, runs_b.end,
+										[ &batch, &scratch, i ]( const index_t j ) {
+											scratch.pairs.emplace_back( std::min( batch[ i ], batch[ j ] ), std::max( batch[ i ], batch[ j ] ) );
+										}
+									);
+								}
+							}
+						}
+					}
+				}
+			);
+
+			for (const PairChunk &scratch : m_chunks)
+			{
+				m_pairs.insert( m_pairs.end(), scratch.pairs.begin(), scratch.pairs.end() );
+			}
+		}
+
+		// statics never go through the batcher, every dynamic object looks them up instead
+		if (m_static_tree.size() > 0)
+		{
+			const size_t chunk = batchers::parallel_chunk( m_objects.size(), m_thread_pool );
+			m_chunks.resize( batchers::parallel_chunk_count( m_objects.size(), chunk ) );
+
+			batchers::parallel_for(
+				m_objects.size(), m_thread_pool,
+				[ this, chunk ]( const size_t begin, const size_t end ) {
+					PairList &pairs = m_chunks[ begin / chunk ].pairs;
+					pairs.clear();
+
+					for (index_t i = begin; i < end; i++)
+					{
+						const object_type &obj = m_objects[ i ];
+						if (!obj.is_activated() || obj.get_type() == ObjectType::Static || !m_reach[ i ])
+							continue;
+
+						m_static_tree.query(
+							obj.get_frame(),
+							[ this, &pairs, &obj, i ]( const index_t static_index ) {
+								const object_type &other = m_objects[ static_index ];
+								if ((m_reach[ i ] & other.get_mask()) && other.get_frame().intersects( obj.get_frame() ))
+									pairs.emplace_back( std::min( i, static_index ), std::max( i, static_index ) );
+								return true;
+							}
+						);
+					}
+				}
+			);
+
+			for (const PairChunk &scratch : m_chunks)
+			{
+				m_pairs.insert( m_pairs.end(), scratch.pairs.begin(), scratch.pairs.end() );
+			}
+		}
+
+		// the chunks only decide where a pair lands before this, the sort makes the order independent of the pool
+		std::sort( m_pairs.begin(), m_pairs.end() );
+		m_pairs.erase( std::unique( m_pairs.begin(), m_pairs.end() ), m_pairs.end() );
+	}
+
+	template<typename _OBJ, typename _BATCHER>
+	void TSpace<_OBJ, _BATCHER>::build_islands() {
+		m_island_builder.reset( m_objects.size() );
+
+		const auto link_pair = [ this ]( const ObjectPair &pair ) {
+			const bool static_a = m_objects[ pair.first ].get_type() == ObjectType::Static;
+			const bool static_b = m_objects[ pair.second ].get_type() == ObjectType::Static;
+
+			if (static_a)
+				m_island_builder.attach( pair.first, pair.second );
+			else if (static_b)
+				m_island_builder.attach( pair.second, pair.first );
+			else
+				m_island_builder.link( pair.first, pair.second );
+		};
+
+		const std::vector<typename pair_cache_type::Entry> &entries = m_pair_cache.get_entries();
+		for (const typename pair_cache_type::Entry &entry : entries)
+		{
+			link_pair( entry.pair );
+		}
+
+		// pairs that were touching last step keep their island for one more step even if the frames drift apart
+		for (const ObjectPair &pair : m_pair_cache.get_ended())
+		{
+			if (pair.second < m_objects.size())
+				link_pair( pair );
+		}
+
+		m_island_builder.build( m_islands );
+
+		// counting sort of the cached pairs by island, every island solves one contiguous range
+		m_island_pair_starts.assign( m_islands.size() + 1, 0 );
+		m_island_pairs.resize( entries.size() );
+
+		const auto get_pair_island = [ this ]( const ObjectPair &pair ) {
+			// at most one side is static, the other one is always in an island
+			const index_t island = m_island_builder.get_island( pair.first );
+			return island != batchers::IslandBuilder::NoIsland ? island : m_island_builder.get_island( pair.second );
+		};
+
+		for (const typename pair_cache_type::Entry &entry : entries)
+		{
+			m_island_pair_starts[ get_pair_island( entry.pair ) + 1 ]++;
+		}
+
+		for (index_t i = 1; i < m_island_pair_starts.size(); i++)
+		{
+			m_island_pair_starts[ i ] += m_island_pair_starts[ i - 1 ];
+		}
+
+		m_island_pair_fill.assign( m_island_pair_starts.begin(), m_island_pair_starts.end() - 1 );
+		for (index_t i = 0; i < entries.size(); i++)
+		{
+			m_island_pairs[ m_island_pair_fill[ get_pair_island( entries[ i ].pair ) ]++ ] = i;
+		}
+	}
+
+	template<typename _OBJ, typename _BATCHER>
+	inline real_t TSpace<_OBJ, _BATCHER>::get_sweep( const ObjectPair &pair ) const {
+		if (!m_speculative)
+			return 0;
+
+		return (m_velocities[ pair.second ] - m_velocities[ pair.first ]).length() * m_dt;
+	}
+
+	template<typename _OBJ, typename _BATCHER>
+	void TSpace<_OBJ, _BATCHER>::collide_island( index_t island ) {
+		std::vector<typename pair_cache_type::Entry> &entries = m_pair_cache.get_entries();
+		const size_t begin = m_island_pair_starts[ island ];
+		const size_t end = m_island_pair_starts[ island + 1 ];
+
+		if constexpr (std::is_same_v<object_type, Object2D>)
+		{
+			collide_island_circles( begin, end );
+		}
+
+		index_t circle_lane = 0;
+		index_t circle_contact = 0;
+		for (size_t i = begin; i < end; i++)
+		{
+			typename pair_cache_type::Entry &entry = entries[ m_island_pairs[ i ] ];
+			const object_type &object_a = m_objects[ entry.pair.first ];
+			const object_type &object_b = m_objects[ entry.pair.second ];
+
+			if (!solvers::responds( object_a.get_type(), object_b.get_type() ))
+			{
+				entry.contacts.clear();
+				continue;
+			}
+
+			// the shapes' frames are swept by how far the objects close in, so speculative contacts see the shapes about to meet
+			const real_t sweep = get_sweep( entry.pair );
+			m_pair_contacts.clear();
+			solvers::for_each_shape_pair(
+				object_a, object_b, sweep,
+				[ this, &entry, &object_a, &object_b, &circle_lane, &circle_contact, sweep ]( const index_t shape_a, const index_t shape_b ) {
+					const typename object_type::shape_type &first = object_a.get_shape( shape_a );
+					const typename object_type::shape_type &second = object_b.get_shape( shape_b );
+					typename pair_cache_type::Contact contact{ static_cast<uint16_t>(shape_a), static_cast<uint16_t>(shape_b), {} };
+
+					bool touching;
+					if constexpr (std::is_same_v<object_type, Object2D>)
+					{
+						if (first.get_type() == ShapeType2D::Circle && second.get_type() == ShapeType2D::Circle)
+						{
+							// already went through the batch, the contacts are keyed and ordered by lane
+							touching = circle_contact < m_circle_contacts.size() && m_circle_contacts[ circle_contact ].pair == circle_lane;
+							if (touching)
+							{
+								const solvers::CircleContact &circle = m_circle_contacts[ circle_contact++ ];
+								const Vector2 position = first.get_circle().center + object_a.get_position() + circle.normal * first.get_circle().radius;
+								contact.manifold.normal = circle.normal;
+								contact.manifold.points[ contact.manifold.point_count++ ] = { position, circle.depth };
+							}
+							circle_lane++;
+						}
+						else
+						{
+							touching = solver_type::get_solver( first.get_type(), second.get_type() )(
+								{ object_a, object_b }, { first, second }, entry.cache, contact.manifold
+							);
+						}
+					}
+					else
+					{
+						// one indirect call per shape pair
+						touching = solver_type::get_solver( first.get_type(), second.get_type() )(
+							{ object_a, object_b }, { first, second }, entry.cache, contact.manifold
+						);
+					}
+
+					// apart for now, but closing fast enough to meet before the next step
+					if (!touching && m_speculative)
+					{
+						const typename object_type::vector_type relative = m_velocities[ entry.pair.second ] - m_velocities[ entry.pair.first ];
+						touching = sweep > Epsilon
+							&& solver_type::get_separation( first.get_type(), second.get_type() )(
+								{ object_a, object_b }, { first, second }, sweep, entry.cache, contact.manifold
+							)
+							&& relative.dot( contact.manifold.normal ) < 0;
+					}
+
+					if (!touching)
+						return;
+
+					// warm starting, the points that were there last step keep their impulse
+					for (const typename pair_cache_type::Contact &previous : entry.contacts)
+					{
+						if (previous.shape_a == contact.shape_a && previous.shape_b == contact.shape_b)
+						{
+							solvers::match_points( previous.manifold, contact.manifold );
+							break;
+						}
+					}
+					m_pair_contacts.push_back( contact );
+				}
+			);
+
+			entry.contacts.assign( m_pair_contacts.begin(), m_pair_contacts.end() );
 		}
 	}
 
-	template<typename _OBJ>
-	TSpace<_OBJ>::TSpace() : m_dt{} {
+	template<typename _OBJ, typename _BATCHER>
+	inline void TSpace<_OBJ, _BATCHER>::apply_impulse( index_t a, index_t b, const typename object_type::vector_type &impulse ) {
+		m_velocities[ a ] -= impulse * m_inverse_masses[ a ];
+		m_velocities[ b ] += impulse * m_inverse_masses[ b ];
 	}
 
-	template<typename _OBJ>
-	void TSpace<_OBJ>::update( real_t deltatime ) {
-		if (deltatime - Epsilon <= 0)
-			deltatime = Epsilon;
+	template<typename _OBJ, typename _BATCHER>
+	inline void TSpace<_OBJ, _BATCHER>::apply_position_impulse( index_t a, index_t b, const typename object_type::vector_type &impulse ) {
+		m_pseudo_velocities[ a ] -= impulse * m_inverse_masses[ a ];
+		m_pseudo_velocities[ b ] += impulse * m_inverse_masses[ b ];
+	}
 
-		m_dt = deltatime;
+	template<typename _OBJ, typename _BATCHER>
+	inline real_t TSpace<_OBJ, _BATCHER>::solve_contact( solvers::TContactConstraint<typename object_type::vector_type> &constraint ) {
+		using vector_type = typename object_type::vector_type;
+		const vector_type &normal = constraint.normal;
 
-		/*
-		- Do we need to recalculate the collision image (BatchResult) per iteration or per frame?
-		+ currently it is per frame
+		// the accumulated normal impulse only ever pushes
+		const real_t closing = (m_velocities[ constraint.body_b ] - m_velocities[ constraint.body_a ]).dot( normal );
+		const real_t accumulated = std::max<real_t>( constraint.normal_impulse - (closing + constraint.approach) * constraint.mass, 0 );
+		const real_t change = accumulated - constraint.normal_impulse;
+		constraint.normal_impulse = accumulated;
+		apply_impulse( constraint.body_a, constraint.body_b, normal * change );
 
-		- Should each impulse be less effective?
-		+ idk
-		*/
-		//constexpr solvers::I2D::SolverProc xx = solvers::I2D::solve<object_type::shape_type_enum::None, object_type::shape_type_enum::None>;
+		// friction stops the sliding, up to the cone the normal impulse allows
+		const vector_type relative = m_velocities[ constraint.body_b ] - m_velocities[ constraint.body_a ];
+		const vector_type sliding = relative - normal * relative.dot( normal );
+		vector_type tangent_impulse = constraint.tangent_impulse - sliding * constraint.mass;
+
+		const real_t limit = constraint.friction * constraint.normal_impulse;
+		const real_t length_squared = tangent_impulse.length_squared();
+		if (length_squared > limit * limit)
+			tangent_impulse = tangent_impulse * (limit / std::sqrt( length_squared ));
+
+		const vector_type tangent_change = tangent_impulse - constraint.tangent_impulse;
+		constraint.tangent_impulse = tangent_impulse;
+		apply_impulse( constraint.body_a, constraint.body_b, tangent_change );
+
+		return std::max( change * change, tangent_change.length_squared() );
+	}
+
+	template<typename _OBJ, typename _BATCHER>
+	void TSpace<_OBJ, _BATCHER>::solve_island( index_t island ) {
+		using vector_type = typename object_type::vector_type;
+		using constraint_type = solvers::TContactConstraint<vector_type>;
+
+		std::vector<typename pair_cache_type::Entry> &entries = m_pair_cache.get_entries();
+		const size_t begin = m_island_pair_starts[ island ];
+		const size_t end = m_island_pair_starts[ island + 1 ];
+
+		// one constraint per contact point, everything the iterations need is cached in it
+		m_constraints.clear();
+		for (size_t i = begin; i < end; i++)
+		{
+			typename pair_cache_type::Entry &entry = entries[ m_island_pairs[ i ] ];
+			const index_t a = entry.pair.first;
+			const index_t b = entry.pair.second;
+			const real_t inverse_mass = m_inverse_masses[ a ] + m_inverse_masses[ b ];
+			if (inverse_mass <= 0)
+				continue;
+
+			const object_type &object_a = m_objects[ a ];
+			const object_type &object_b = m_objects[ b ];
+			const real_t friction = std::sqrt( object_a.get_friction() * object_b.get_friction() );
+			const real_t restitution = std::max( object_a.get_restitution(), object_b.get_restitution() );
+
+			for (typename pair_cache_type::Contact &contact : entry.contacts)
+			{
+				const vector_type &normal = contact.manifold.normal;
+				const real_t relative_velocity = (m_velocities[ b ] - m_velocities[ a ]).dot( normal );
+				for (index_t p = 0; p < contact.manifold.point_count; p++)
+				{
+					auto &point = contact.manifold.points[ p ];
+					m_constraints.push_back(
+						{
+							a, b, normal, 1 / inverse_mass, friction, restitution,
+							std::max<real_t>( -point.depth - SpeculativeSlop, 0 ) / m_dt,
+							relative_velocity,
+							std::max<real_t>( point.depth, 0 ),
+							point.normal_impulse, point.tangent_impulse, 0,
+							&point
+						}
+					);
+				}
+			}
+		}
 
-		// preprocessor
-		for (object_type &obj : m_objects)
+		// warm start with last step's impulses
+		for (const constraint_type &constraint : m_constraints)
 		{
-			if (obj.is_frame_dirty())
-				obj.recalculate_frame();
+			apply_impulse( constraint.body_a, constraint.body_b, constraint.normal * constraint.normal_impulse + constraint.tangent_impulse );
 		}
 
-		m_batcher.try_rebuild( m_objects );
-		const BatchResult &batch_results = m_batcher.get_results();
+		// big islands are solved 'simd::SimdWidth' contacts at a time, whatever doesn't fit in a group goes through the scalar loop
+		const bool wide = m_wide_solver && m_constraints.size() >= simd::SimdWidth * 4;
+		if (wide)
+			m_wide_contacts.pack( m_constraints, m_inverse_masses );
+
+		// sequential impulses, stops early once no impulse changes by much
+		for (index_t iteration = 0; iteration < PhysicsIterations; iteration++)
+		{
+			real_t largest_change = 0;
+			if (wide)
+			{
+				largest_change = m_wide_contacts.solve( m_velocities );
+				for (index_t i : m_wide_contacts.get_tail())
+				{
+					largest_change = std::max( largest_change, solve_contact( m_constraints[ i ] ) );
+				}
+			}
+			else
+			{
+				for (constraint_type &constraint : m_constraints)
+				{
+					largest_change = std::max( largest_change, solve_contact( constraint ) );
+				}
+			}
+
+			// squared, like the changes
+			if (largest_change <= Epsilon * Epsilon)
+				break;
+		}
+
+		if (wide)
+			m_wide_contacts.unpack( m_constraints );
+
+		// the points that stopped a fast enough approach bounce back
+		for (constraint_type &constraint : m_constraints)
+		{
+			if (constraint.restitution <= 0 || constraint.relative_velocity > -RestitutionThreshold || constraint.normal_impulse <= 0)
+				continue;
+
+			const real_t closing = (m_velocities[ constraint.body_b ] - m_velocities[ constraint.body_a ]).dot( constraint.normal );
+			const real_t accumulated = std::max<real_t>(
+				constraint.normal_impulse - (closing + constraint.restitution * constraint.relative_velocity) * constraint.mass, 0
+			);
+			apply_impulse( constraint.body_a, constraint.body_b, constraint.normal * (accumulated - constraint.normal_impulse) );
+			constraint.normal_impulse = accumulated;
+		}
 
-		for (const ObjectBatch &batch : batch_results)
+		// split impulse, the overlap is pushed out through the pseudo velocities
+		for (index_t iteration = 0; iteration < PositionIterations; iteration++)
 		{
-			update( batch );
+			for (constraint_type &constraint : m_constraints)
+			{
+				if (constraint.depth <= PenetrationSlop)
+					continue;
+
+				const real_t target = PositionCorrection * (constraint.depth - PenetrationSlop) / m_dt;
+				const real_t separating = (m_pseudo_velocities[ constraint.body_b ] - m_pseudo_velocities[ constraint.body_a ]).dot( constraint.normal );
+				const real_t accumulated = std::max<real_t>( constraint.position_impulse + (target - separating) * constraint.mass, 0 );
+				apply_position_impulse( constraint.body_a, constraint.body_b, constraint.normal * (accumulated - constraint.position_impulse) );
+				constraint.position_impulse = accumulated;
+			}
 		}
 
+		for (const constraint_type &constraint : m_constraints)
+		{
+			constraint.point->normal_impulse = constraint.normal_impulse;
+			constraint.point->tangent_impulse = constraint.tangent_impulse;
+		}
 	}
 
-	template<typename _OBJ>
-	void TSpace<_OBJ>::update( const ObjectBatch &objects ) {
-		for (index_t iteration = 0; iteration < PhysicsIterations; iteration++)
+	template<typename _OBJ, typename _BATCHER>
+	void TSpace<_OBJ, _BATCHER>::collide_island_circles( size_t begin, size_t end ) {
+		// explicitly instantiated for 3D spaces too, where there's nothing to do
+		if constexpr (std::is_same_v<object_type, Object2D>)
 		{
+			const std::vector<typename pair_cache_type::Entry> &entries = m_pair_cache.get_entries();
 
-			for (size_t i = 0; i < objects.size(); i++)
+			// packs the world space circles of the island pairs [begin, end)
+			m_circle_pairs.clear();
+			for (size_t i = begin; i < end; i++)
 			{
-				object_type &object_a = m_objects[ objects[ i ] ];
-				for (index_t j = i + 1; j < objects.size(); j++)
-				{
-					object_type &object_b = m_objects[ objects[ j ] ];
+				const ObjectPair &pair = entries[ m_island_pairs[ i ] ].pair;
+				const object_type &object_a = m_objects[ pair.first ];
+				const object_type &object_b = m_objects[ pair.second ];
 
-					if (object_a.get_type() == ObjectType::Static && object_b.get_type() == ObjectType::Static)
-						continue;
+				// same pairs, sweep and shape pair order as 'collide_island', which counts the lanes the same way
+				if (!solvers::responds( object_a.get_type(), object_b.get_type() ))
+					continue;
 
-					// bounding boxes not intersecting, objects can't be colliding
-					if (!object_a.get_frame().intersects( object_b.get_frame() ))
-						continue;
+				solvers::for_each_shape_pair(
+					object_a, object_b, get_sweep( pair ),
+					[ this, &object_a, &object_b ]( const index_t shape_a, const index_t shape_b ) {
+						if (object_a.get_shape( shape_a ).get_type() != ShapeType2D::Circle
+								|| object_b.get_shape( shape_b ).get_type() != ShapeType2D::Circle)
+							return;
 
+						const Circle &circle_a = object_a.get_shape( shape_a ).get_circle();
+						const Circle &circle_b = object_b.get_shape( shape_b ).get_circle();
 
-					//solvers::TIterative<object_type>::solve( { object_a, object_b }, { object_a.get_shape(), object_b.get_shape() } );
-				}
+						// keyed by lane, the contacts come back with the lane they were found in
+						m_circle_pairs.push_back(
+							static_cast<index_t>(m_circle_pairs.size()),
+							{ circle_a.center + object_a.get_position(), circle_a.radius },
+							{ circle_b.center + object_b.get_position(), circle_b.radius }
+						);
+					}
+				);
 			}
 
+			m_circle_contacts.clear();
+			solvers::collide_circles( m_circle_pairs, m_circle_contacts );
+		}
+		else
+		{
+			(void)begin;
+			(void)end;
 		}
 	}
 
-	template<typename _OBJ>
-	void TSpace<_OBJ>::add_object( const object_type &object ) {
+	template<typename _OBJ, typename _BATCHER>
+	void TSpace<_OBJ, _BATCHER>::add_object( const object_type &object ) {
 		m_objects.push_back( object );
-		m_batcher.invalidate();
+
+		object_type &added = m_objects.back();
+		if (added.is_frame_dirty())
+			added.recalculate_frame();
+
+		if (added.get_type() == ObjectType::Static)
+		{
+			if (added.is_activated())
+				m_static_tree.insert( m_objects.size() - 1, added.get_frame() );
+			return;
+		}
+
+		m_batcher.add_object( m_objects.size() - 1, added );
+	}
+
+	template<typename _OBJ, typename _BATCHER>
+	void TSpace<_OBJ, _BATCHER>::update_static( index_t index ) {
+		object_type &obj = m_objects[ index ];
+		if (obj.is_frame_dirty())
+			obj.recalculate_frame();
+
+		if (m_static_tree.contains( index ))
+			m_static_tree.remove( index );
+
+		if (obj.is_activated())
+			m_static_tree.insert( index, obj.get_frame() );
+	}
+
+	template<typename _OBJ, typename _BATCHER>
+	void TSpace<_OBJ, _BATCHER>::remove_static( index_t index ) {
+		m_objects[ index ].deactivate();
+
+		if (m_static_tree.contains( index ))
+			m_static_tree.remove( index );
 	}
 
 #pragma region(ShapeUnion)
 
-	// FIXME: why the polygon??
-	Shape2D::ShapeUnion2D::ShapeUnion2D( shape_type_enum type ) : polygon{} {
-		(void)type;
-		// FIXME: use 'type'
+	// only the polygon owns memory, every other member is constructed and copied as plain data
+	Shape2D::ShapeUnion2D::ShapeUnion2D( shape_type_enum type ) {
+		switch (type)
+		{
+		case ShapeType2D::Polygon:
+			new (&polygon) Polygon2D();
+			return;
+		case ShapeType2D::Circle:
+			new (&circle) Circle();
+			return;
+		case ShapeType2D::Triangle:
+			new (&triangle) Triangle();
+			return;
+		case ShapeType2D::Line:
+			new (&line) Line();
+			return;
+		case ShapeType2D::Ray:
+			new (&ray) Ray2D();
+			return;
+		case ShapeType2D::Capsule:
+			new (&capsule) Capsule2D();
+			return;
+		default:
+			new (&rectangle) Rect();
+			return;
+		}
 	}
 
-	Shape2D::ShapeUnion2D::ShapeUnion2D( const ShapeUnion2D &copy ) : polygon{ copy.polygon } {
+	Shape2D::ShapeUnion2D::ShapeUnion2D( shape_type_enum type, const ShapeUnion2D &copy ) {
+		switch (type)
+		{
+		case ShapeType2D::Polygon:
+			new (&polygon) Polygon2D( copy.polygon );
+			return;
+		case ShapeType2D::Circle:
+			new (&circle) Circle( copy.circle );
+			return;
+		case ShapeType2D::Triangle:
+			new (&triangle) Triangle( copy.triangle );
+			return;
+		case ShapeType2D::Line:
+			new (&line) Line( copy.line );
+			return;
+		case ShapeType2D::Ray:
+			new (&ray) Ray2D( copy.ray );
+			return;
+		case ShapeType2D::Capsule:
+			new (&capsule) Capsule2D( copy.capsule );
+			return;
+		default:
+			new (&rectangle) Rect( copy.rectangle );
+			return;
+		}
 	}
 
+	// the owning shape calls 'destroy', the union can't know what to destroy on its own
 	Shape2D::ShapeUnion2D::~ShapeUnion2D() {
 	}
 
-	Shape2D::ShapeUnion2D &Shape2D::ShapeUnion2D::operator=( const ShapeUnion2D &other ) {
-		// FIXME: why the polygon??
-		polygon = other.polygon;
-		return *this;
+	void Shape2D::ShapeUnion2D::destroy( shape_type_enum type ) {
+		if (type == ShapeType2D::Polygon)
+			polygon.~Polygon2D();
 	}
 
-	Shape3D::ShapeUnion3D::ShapeUnion3D( shape_type_enum type ) : polygon{} {
-		(void)type;
-		// FIXME: use 'type'
+	// the meshes are shared, copying the shape only copies the handle
+	Shape3D::ShapeUnion3D::ShapeUnion3D( shape_type_enum type ) {
+		switch (type)
+		{
+		case ShapeType3D::Polygon:
+			new (&polygon) Polygon3D();
+			return;
+		case ShapeType3D::Mesh:
+			new (&mesh) std::shared_ptr<const TriangleMesh>();
+			return;
+		case ShapeType3D::HeightField:
+			new (&height_field) std::shared_ptr<const HeightField>();
+			return;
+		case ShapeType3D::Sphere:
+			new (&sphere) Sphere();
+			return;
+		case ShapeType3D::Pyramid:
+			new (&pyramid) Pyramid();
+			return;
+		case ShapeType3D::Plane:
+			new (&plane) Plane();
+			return;
+		case ShapeType3D::Ray:
+			new (&ray) Ray3D();
+			return;
+		case ShapeType3D::Capsule:
+			new (&capsule) Capsule3D();
+			return;
+		default:
+			new (&box) AABB();
+			return;
+		}
 	}
 
-	// FIXME: why the polygon??
-	Shape3D::ShapeUnion3D::ShapeUnion3D( const ShapeUnion3D &copy ) : polygon{ copy.polygon } {
+	Shape3D::ShapeUnion3D::ShapeUnion3D( shape_type_enum type, const ShapeUnion3D &copy ) {
+		switch (type)
+		{
+		case ShapeType3D::Polygon:
+			new (&polygon) Polygon3D( copy.polygon );
+			return;
+		case ShapeType3D::Mesh:
+			new (&mesh) std::shared_ptr<const TriangleMesh>( copy.mesh );
+			return;
+		case ShapeType3D::HeightField:
+			new (&height_field) std::shared_ptr<const HeightField>( copy.height_field );
+			return;
+		case ShapeType3D::Sphere:
+			new (&sphere) Sphere( copy.sphere );
+			return;
+		case ShapeType3D::Pyramid:
+			new (&pyramid) Pyramid( copy.pyramid );
+			return;
+		case ShapeType3D::Plane:
+			new (&plane) Plane( copy.plane );
+			return;
+		case ShapeType3D::Ray:
+			new (&ray) Ray3D( copy.ray );
+			return;
+		case ShapeType3D::Capsule:
+			new (&capsule) Capsule3D( copy.capsule );
+			return;
+		default:
+			new (&box) AABB( copy.box );
+			return;
+		}
 	}
 
 	Shape3D::ShapeUnion3D::~ShapeUnion3D() {
 	}
 
-	Shape3D::ShapeUnion3D &Shape3D::ShapeUnion3D::operator=( const ShapeUnion3D &other ) {
-		// FIXME: why the polygon??
-		polygon = other.polygon;
-		return *this;
+	void Shape3D::ShapeUnion3D::destroy( shape_type_enum type ) {
+		switch (type)
+		{
+		case ShapeType3D::Polygon:
+			polygon.~Polygon3D();
+			return;
+		case ShapeType3D::Mesh:
+			mesh.~shared_ptr();
+			return;
+		case ShapeType3D::HeightField:
+			height_field.~shared_ptr();
+			return;
+		default:
+			return;
+		}
 	}
 #pragma endregion
 
-	Shape2D::Shape2D() : m_data{ ShapeType2D::Rectangle } {
+	Shape2D::Shape2D() : Shape2D( ShapeType2D::Rectangle ) {
 	}
 
 	Shape2D::Shape2D( shape_type_enum type ) : m_data{ type } {
+		m_type = type;
+	}
+
+	Shape2D::Shape2D( const Shape2D &copy ) : BaseShape{ copy }, m_data{ copy.m_type, copy.m_data } {
+	}
+
+	Shape2D &Shape2D::operator=( const Shape2D &other ) {
+		if (this == &other)
+			return *this;
+
+		m_data.destroy( m_type );
+		BaseShape::operator=( other );
+		new (&m_data) ShapeUnion2D( other.m_type, other.m_data );
+		return *this;
+	}
+
+	Shape2D::~Shape2D() {
+		m_data.destroy( m_type );
 	}
 
 	void Shape2D::recalculate_bounding_box() {
 		switch (m_type)
 		{
 		case ShapeType2D::Polygon:
+			m_data.polygon.try_recalculate();
 			m_bounding_box = calculate_bounding_box( m_data.polygon );
 			return;
 		case ShapeType2D::Circle:
@@ -527,19 +6483,285 @@ namespace pphy
 		case ShapeType2D::Ray:
 			m_bounding_box = calculate_bounding_box( m_data.ray );
 			return;
+		case ShapeType2D::Capsule:
+			m_bounding_box = calculate_bounding_box( m_data.capsule );
+			return;
 		default:
 			m_bounding_box = { 0, 0, 0, 0 };
 			break;
 		}
 	}
 
-	Shape3D::Shape3D() : m_data{ ShapeType3D::Box } {
+	Shape3D::Shape3D() : Shape3D( ShapeType3D::Box ) {
 	}
 
 	Shape3D::Shape3D( shape_type_enum type ) : m_data{ type } {
+		m_type = type;
+	}
+
+	Shape3D::Shape3D( const std::shared_ptr<const TriangleMesh> &mesh ) : Shape3D( ShapeType3D::Mesh ) {
+		m_data.mesh = mesh;
+		recalculate_bounding_box();
+	}
+
+	Shape3D::Shape3D( const std::shared_ptr<const HeightField> &height_field ) : Shape3D( ShapeType3D::HeightField ) {
+		m_data.height_field = height_field;
+		recalculate_bounding_box();
+	}
+
+	Shape3D::Shape3D( const Shape3D &copy ) : BaseShape{ copy }, m_data{ copy.m_type, copy.m_data } {
+	}
+
+	Shape3D &Shape3D::operator=( const Shape3D &other ) {
+		if (this == &other)
+			return *this;
+
+		m_data.destroy( m_type );
+		BaseShape::operator=( other );
+		new (&m_data) ShapeUnion3D( other.m_type, other.m_data );
+		return *this;
+	}
+
+	Shape3D::~Shape3D() {
+		m_data.destroy( m_type );
+	}
+
+	// the union's active member changes, so the old one is destroyed before the handle is constructed over it
+	void Shape3D::set_mesh( const std::shared_ptr<const TriangleMesh> &mesh ) noexcept {
+		if (m_type != ShapeType3D::Mesh)
+		{
+			m_data.destroy( m_type );
+			new (&m_data.mesh) std::shared_ptr<const TriangleMesh>();
+			m_type = ShapeType3D::Mesh;
+		}
+
+		m_data.mesh = mesh;
+		recalculate_bounding_box();
+	}
+
+	void Shape3D::set_height_field( const std::shared_ptr<const HeightField> &height_field ) noexcept {
+		if (m_type != ShapeType3D::HeightField)
+		{
+			m_data.destroy( m_type );
+			new (&m_data.height_field) std::shared_ptr<const HeightField>();
+			m_type = ShapeType3D::HeightField;
+		}
+
+		m_data.height_field = height_field;
+		recalculate_bounding_box();
 	}
 
 	void Shape3D::recalculate_bounding_box() {
+		switch (m_type)
+		{
+		case ShapeType3D::Box:
+			m_bounding_box = calculate_bounding_box( m_data.box );
+			return;
+		case ShapeType3D::Sphere:
+			m_bounding_box = calculate_bounding_box( m_data.sphere );
+			return;
+		case ShapeType3D::Pyramid:
+			m_bounding_box = calculate_bounding_box( m_data.pyramid );
+			return;
+		case ShapeType3D::Plane:
+			m_bounding_box = calculate_bounding_box( m_data.plane );
+			return;
+		case ShapeType3D::Ray:
+			m_bounding_box = calculate_bounding_box( m_data.ray );
+			return;
+		case ShapeType3D::Capsule:
+			m_bounding_box = calculate_bounding_box( m_data.capsule );
+			return;
+		case ShapeType3D::Polygon:
+			m_bounding_box = calculate_bounding_box( m_data.polygon );
+			return;
+		case ShapeType3D::Mesh:
+			m_bounding_box = m_data.mesh ? m_data.mesh->get_bounds() : AABB{};
+			return;
+		case ShapeType3D::HeightField:
+			m_bounding_box = m_data.height_field ? m_data.height_field->get_bounds() : AABB{};
+			return;
+		default:
+			m_bounding_box = {};
+			break;
+		}
+	}
+
+
+#pragma region(Meshes)
+
+	// the 'v' and 'f' lines of a wavefront obj source, everything else (normals, texture coordinates, groups...) is skipped
+	// face corners can be 'v', 'v/vt', 'v//vn' or 'v/vt/vn', negative indices count back from the last vertex read
+	static void read_obj( const std::string &source, std::vector<Vector3> &vertices, std::vector<TriangleMesh::Face> *faces ) {
+		std::istringstream stream{ source };
+		std::string line;
+		std::string corner;
+		std::vector<int64_t> corners;
+		while (std::getline( stream, line ))
+		{
+			std::istringstream words{ line };
+			std::string keyword;
+			words >> keyword;
+
+			if (keyword == "v")
+			{
+				Vector3 vertex{};
+				if (words >> vertex.x >> vertex.y >> vertex.z)
+					vertices.push_back( vertex );
+				continue;
+			}
+
+			if (keyword != "f" || !faces)
+				continue;
+
+			corners.clear();
+			while (words >> corner)
+			{
+				// stops at the first '/'
+				const int64_t index = std::strtoll( corner.c_str(), nullptr, 10 );
+				corners.push_back( index < 0 ? static_cast<int64_t>(vertices.size()) + index : index - 1 );
+			}
+
+			for (index_t i = 2; i < corners.size(); i++)
+			{
+				faces->push_back( {
+					static_cast<uint32_t>(corners[ 0 ]), static_cast<uint32_t>(corners[ i - 1 ]), static_cast<uint32_t>(corners[ i ])
+				} );
+			}
+		}
+	}
+
+	TriangleMesh::TriangleMesh( const std::vector<Vector3> &vertices, const std::vector<Face> &faces ) {
+		set( vertices, faces );
+	}
+
+	void TriangleMesh::set( const std::vector<Vector3> &vertices, const std::vector<Face> &faces ) {
+		m_vertices = vertices;
+		m_faces = faces;
+		m_bounds = {};
+
+		std::vector<AABB> frames( m_faces.size() );
+		for (index_t i = 0; i < m_faces.size(); i++)
+		{
+			frames[ i ] = { m_vertices[ m_faces[ i ][ 0 ] ], m_vertices[ m_faces[ i ][ 0 ] ] };
+			frames[ i ].encase( m_vertices[ m_faces[ i ][ 1 ] ] );
+			frames[ i ].encase( m_vertices[ m_faces[ i ][ 2 ] ] );
+
+			if (i == 0)
+				m_bounds = frames[ i ];
+			else
+				m_bounds.encase( frames[ i ] );
+		}
+
+		m_tree.build( frames );
+	}
+
+	bool TriangleMesh::load_obj( const std::string &source ) {
+		std::vector<Vector3> vertices;
+		std::vector<Face> faces;
+		read_obj( source, vertices, &faces );
+
+		// faces pointing at vertices that aren't there
+		faces.erase(
+			std::remove_if(
+				faces.begin(), faces.end(),
+				[ &vertices ]( const Face &face ) {
+					return face[ 0 ] >= vertices.size() || face[ 1 ] >= vertices.size() || face[ 2 ] >= vertices.size();
+				}
+			),
+			faces.end()
+		);
+
+		if (faces.empty())
+			return false;
+
+		set( vertices, faces );
+		return true;
+	}
+
+	HeightField::HeightField( index_t columns, index_t rows, const std::vector<real_t> &heights, const Vector2 &spacing, const Vector2 &origin ) {
+		set( columns, rows, heights, spacing, origin );
+	}
+
+	void HeightField::set( index_t columns, index_t rows, const std::vector<real_t> &heights, const Vector2 &spacing, const Vector2 &origin ) {
+		m_columns = columns;
+		m_rows = rows;
+		m_spacing = spacing;
+		m_origin = origin;
+		m_heights = heights;
+		m_heights.resize( columns * rows );
+		m_bounds = {};
+
+		if (m_heights.empty())
+			return;
+
+		// the solid under the surface goes as deep as the grid is wide, so bodies pushed under it still find it
+		const auto [ lowest, highest ] = std::minmax_element( m_heights.begin(), m_heights.end() );
+		const real_t width = std::max( { (columns - 1) * spacing.x, (rows - 1) * spacing.y, spacing.x, spacing.y } );
+		m_bounds = {
+			{ origin.x, *lowest - width, origin.y },
+			{ origin.x + (columns - 1) * spacing.x, *highest, origin.y + (rows - 1) * spacing.y }
+		};
+	}
+
+	bool HeightField::load_obj( const std::string &source ) {
+		std::vector<Vector3> vertices;
+		read_obj( source, vertices, nullptr );
+		if (vertices.size() < 4)
+			return false;
+
+		AABB bounds{ vertices[ 0 ], vertices[ 0 ] };
+		for (const Vector3 &vertex : vertices)
+		{
+			bounds.encase( vertex );
+		}
+
+		// the distinct x and z coordinates make the grid's columns and rows
+		const real_t tolerance = std::max<real_t>( 1, std::max( bounds.end.x - bounds.begin.x, bounds.end.z - bounds.begin.z ) ) * Epsilon;
+		const auto count_lines = [ &vertices, tolerance ]( index_t axis ) {
+			std::vector<real_t> positions( vertices.size() );
+			for (index_t i = 0; i < vertices.size(); i++)
+			{
+				positions[ i ] = (&vertices[ i ].x)[ axis ];
+			}
+			std::sort( positions.begin(), positions.end() );
+
+			index_t count = 1;
+			for (index_t i = 1; i < positions.size(); i++)
+			{
+				if (positions[ i ] - positions[ i - 1 ] > tolerance)
+					count++;
+			}
+			return count;
+		};
+
+		const index_t columns = count_lines( 0 );
+		const index_t rows = count_lines( 2 );
+		if (columns < 2 || rows < 2 || columns * rows != vertices.size())
+			return false;
+
+		const Vector2 spacing{ (bounds.end.x - bounds.begin.x) / (columns - 1), (bounds.end.z - bounds.begin.z) / (rows - 1) };
+		std::vector<real_t> heights( vertices.size() );
+		std::vector<bool> filled( vertices.size(), false );
+		for (const Vector3 &vertex : vertices)
+		{
+			const real_t x = (vertex.x - bounds.begin.x) / spacing.x;
+			const real_t z = (vertex.z - bounds.begin.z) / spacing.y;
+			const index_t column = static_cast<index_t>(std::round( x ));
+			const index_t row = static_cast<index_t>(std::round( z ));
+
+			// off the regular grid, or two samples in one spot
+			if (std::abs( x - column ) * spacing.x > tolerance || std::abs( z - row ) * spacing.y > tolerance || filled[ row * columns + column ])
+				return false;
+
+			heights[ row * columns + column ] = vertex.y;
+			filled[ row * columns + column ] = true;
+		}
+
+		set( columns, rows, heights, spacing, { bounds.begin.x, bounds.begin.z } );
+		return true;
 	}
 
+#pragma endregion
+
 }
@@ -9,7 +9,15 @@ zahr abdullatif babker (C) 2024-2025
 
 #include "pphy/base.h"
 #include "pphy/vector.h"
+#include "pphy/simd.h"
 #include <vector>
+#include <limits>
+#include <functional>
+#include <array>
+#include <type_traits>
+#include <algorithm>
+#include <memory>
+#include <string>
 
 namespace pphy
 {
@@ -29,6 +37,9 @@ namespace pphy
 		Line,
 		Ray,
 		Polygon,
+		Capsule,
+		// not a shape, the number of shape types
+		Count,
 	};
 
 	enum class ShapeType3D
@@ -40,6 +51,12 @@ namespace pphy
 		Plane,
 		Ray,
 		Polygon,
+		Capsule,
+		// static level geometry, never moved by the physics
+		Mesh,
+		HeightField,
+		// not a shape, the number of shape types
+		Count,
 	};
 
 	enum class ObjectType
@@ -67,6 +84,26 @@ namespace pphy
 		ObjFlag_NeverSleeps = 0x0001,
 	};
 	using CollisionMask = uint32_t;
+	// row 'i' holds the layers layer 'i' interacts with, one row per bit of CollisionMask
+	using LayerMatrix = std::array<CollisionMask, sizeof( CollisionMask ) * 8>;
+
+	/// @brief the caller's thread pool, the spaces and batchers hand their parallel loops to it
+	/// @note the work is always split the same way for a given concurrency and merged in a fixed order,
+	/// so the results never depend on which thread ran what
+	class IThreadPool
+	{
+	public:
+		using Task = std::function<void( size_t task )>;
+
+		virtual ~IThreadPool() = default;
+
+		/// @returns how many tasks can run at once, the parallel loops are split in this many chunks
+		virtual size_t get_concurrency() const = 0;
+
+		/// @brief runs 'task( 0 )' to 'task( task_count - 1 )' and returns once all of them are done
+		/// @note the calling thread is free to take tasks too
+		virtual void dispatch( size_t task_count, const Task &task ) = 0;
+	};
 
 	template <typename _VEC>
 	struct TFrame
@@ -75,6 +112,7 @@ namespace pphy
 		using vector_type = _VEC;
 		using value_type = typename vector_type::value_type;
 		using lower_rank = TFrame<typename vector_type::lower_rank>;
+		static constexpr index_t dimensions = sizeof( vector_type ) / sizeof( value_type );
 
 		inline constexpr TFrame() : begin{}, end{} {
 		}
@@ -92,6 +130,15 @@ namespace pphy
 
 		inline constexpr this_type expanded( value_type margin ) const;
 
+		/// @returns true if 'other' lies completely inside this frame
+		inline constexpr bool contains( const this_type &other ) const;
+
+		/// @returns the perimeter for Rect and the surface area for AABB, used as the tree insertion cost
+		inline constexpr value_type measure() const;
+
+		/// @returns the corner furthest along 'direction'
+		inline constexpr vector_type support( const vector_type &direction ) const;
+
 		inline constexpr this_type encasing( const this_type &other ) const {
 			this_type copy = *this;
 			copy.encase( other );
@@ -108,6 +155,119 @@ namespace pphy
 	using Rect = TFrame<Vector2>;
 	using AABB = TFrame<Vector3>;
 
+	/// @brief frames stored as one array per axis and side, so simd::overlap_mask can test several at once
+	/// @note the arrays are padded with empty frames, lanes past 'size()' never overlap anything
+	template <typename _FRAME>
+	class TFrameSoA
+	{
+	public:
+		using frame_type = _FRAME;
+		using value_type = typename frame_type::value_type;
+		static constexpr index_t dimensions = frame_type::dimensions;
+
+		inline size_t size() const {
+			return m_count;
+		}
+
+		/// @brief resizes to 'count' frames, new frames are empty
+		inline void resize( size_t count );
+
+		inline void clear() {
+			resize( 0 );
+		}
+
+		inline void set( index_t index, const frame_type &frame ) {
+			const value_type *const begin = &frame.begin.x;
+			const value_type *const end = &frame.end.x;
+			for (index_t axis = 0; axis < dimensions; axis++)
+			{
+				m_begins[ axis ][ index ] = begin[ axis ];
+				m_ends[ axis ][ index ] = end[ axis ];
+			}
+		}
+
+		/// @brief marks the frame at 'index' as overlapping nothing (inactive objects)
+		inline void set_empty( index_t index );
+
+		inline void push_back( const frame_type &frame ) {
+			resize( m_count + 1 );
+			set( m_count - 1, frame );
+		}
+
+		inline value_type get_begin( index_t index, index_t axis ) const {
+			return m_begins[ axis ][ index ];
+		}
+
+		/// @returns a bitmask of the frames in [first, first + simd::SimdWidth) overlapping 'frame'
+		inline uint32_t overlap_mask( const frame_type &frame, index_t first ) const;
+
+		/// @brief calls 'proc( index )' for every frame in [first, last) overlapping 'frame'
+		template <typename _PROC>
+		inline void for_each_overlap( const frame_type &frame, index_t first, index_t last, _PROC &&proc ) const;
+
+	private:
+		size_t m_count = 0;
+		std::vector<value_type> m_begins[ dimensions ];
+		std::vector<value_type> m_ends[ dimensions ];
+	};
+	using RectSoA = TFrameSoA<Rect>;
+	using AABBSoA = TFrameSoA<AABB>;
+
+	/// @brief bounding volume hierarchy over a fixed set of frames, the shapes of one object or the triangles of a mesh
+	/// @note built from scratch when the frames change, objects with few shapes don't get one
+	template <typename _FRAME>
+	class TShapeTree
+	{
+	public:
+		using frame_type = _FRAME;
+		using vector_type = typename frame_type::vector_type;
+		// testing every shape pair is cheaper below this
+		static constexpr index_t MinimumShapes = 4;
+		// deepest level 'build' creates, the query stacks are sized for it; median splits only get there past 2^32 shapes
+		static constexpr index_t MaxDepth = 32;
+
+		/// @brief builds the hierarchy over 'frames', leaf 'i' is shape 'i'
+		void build( const std::vector<frame_type> &frames );
+
+		inline void clear() {
+			m_nodes.clear();
+			m_shapes.clear();
+		}
+
+		inline bool empty() const {
+			return m_nodes.empty();
+		}
+
+		/// @brief calls 'proc( shape )' for every shape whose frame intersects 'region'
+		template <typename _PROC>
+		inline void query( const frame_type &region, _PROC &&proc ) const;
+
+		/// @brief calls 'proc( shape, other_shape )' for every shape of this tree intersecting a shape of 'other'
+		/// @param offset where 'other' is relative to this tree, both trees are in their own local space
+		/// @param reach how far apart the frames can be and still count, for shapes about to meet
+		template <typename _PROC>
+		inline void query_pairs( const TShapeTree &other, const vector_type &offset, real_t reach, _PROC &&proc ) const;
+
+	private:
+		struct Node
+		{
+			frame_type frame;
+			// the first child for inner nodes (the second one follows it), the first of 'm_shapes' for leaves
+			index_t first;
+			// zero for inner nodes
+			index_t count;
+		};
+
+		// fills 'node' with the shapes [begin, end) of 'm_shapes', splitting them at the median centroid of the longest axis
+		// nodes at 'MaxDepth' become leaves whatever their size
+		void build_node( index_t node, const std::vector<frame_type> &frames, index_t begin, index_t end, index_t depth );
+
+	private:
+		std::vector<Node> m_nodes;
+		// shape indices, every leaf owns a range
+		std::vector<index_t> m_shapes;
+	};
+
 	template <typename _VEC>
 	class TPolygon
 	{
@@ -127,6 +287,34 @@ namespace pphy
 			return m_bounds;
 		}
 
+		inline const std::vector<vector_type> &get_points() const {
+			return m_points;
+		}
+
+		inline void set_points( const std::vector<vector_type> &points ) {
+			m_points = points;
+			m_dirty = true;
+		}
+
+		inline void set_point( index_t index, const vector_type &point ) {
+			m_points[ index ] = point;
+			m_dirty = true;
+		}
+
+		inline void add_point( const vector_type &point ) {
+			m_points.push_back( point );
+			m_dirty = true;
+		}
+
+		/// @returns the point furthest along 'direction', only meaningful for convex polygons
+		inline vector_type support( const vector_type &direction ) const;
+
+		/// @returns the outward unit normal of every edge, edge 'i' goes from point 'i' to point 'i + 1'
+		/// @note only filled for 2D polygons, valid after 'recalculate'
+		inline const std::vector<vector_type> &get_normals() const {
+			return m_normals;
+		}
+
 		inline void try_recalculate() {
 			if (m_dirty)
 				recalculate();
@@ -134,11 +322,12 @@ namespace pphy
 		inline void recalculate();
 
 	private:
-		bool m_dirty;
+		bool m_dirty = true;
 		vector_type m_center;
 		frame_type m_bounds;
-		Winding m_winding;
+		Winding m_winding = Winding::None;
 		std::vector<vector_type> m_points;
+		std::vector<vector_type> m_normals;
 	};
 	using Polygon2D = TPolygon<Vector2>;
 	using Polygon3D = TPolygon<Vector3>;
@@ -153,6 +342,9 @@ namespace pphy
 		inline constexpr bool is_point_inside( const vector_type &point ) const;
 		inline constexpr bool is_intersecting_segment( const vector_type &p0, const vector_type &p1, segment_type &intersection ) const;
 
+		/// @returns the point of the surface furthest along 'direction'
+		inline vector_type support( const vector_type &direction ) const;
+
 		vector_type center;
 		float radius;
 	};
@@ -160,11 +352,35 @@ namespace pphy
 	using Sphere = TRound<Vector3>;
 	//using HyperSphere = TRound<Vector4>;
 
+	/// @brief the segment from 'start' to 'end' grown by 'radius'
+	template <typename _VEC>
+	struct TCapsule
+	{
+		using vector_type = _VEC;
+
+		/// @returns the point of the surface furthest along 'direction'
+		inline vector_type support( const vector_type &direction ) const;
+
+		/// @returns the point of the segment closest to 'point'
+		inline vector_type closest_point( const vector_type &point ) const;
+
+		vector_type start;
+		vector_type end;
+		float radius;
+	};
+	using Capsule2D = TCapsule<Vector2>;
+	using Capsule3D = TCapsule<Vector3>;
+
+	/// @brief a triangle (or a pyramid) standing on 'base', the tip is at 'base + head_extent'
+	/// @note the base is 'base_size' wide (a 'base_size' rectangle for pyramids), centered on 'base' and facing the tip
 	template <typename _VEC>
 	struct TPointy
 	{
 		using vector_type = _VEC;
 
+		/// @returns the corner furthest along 'direction'
+		inline vector_type support( const vector_type &direction ) const;
+
 		vector_type base;
 		vector_type head_extent;
 		typename vector_type::lower_rank base_size;
@@ -184,6 +400,7 @@ namespace pphy
 		vector_type direction;
 	};
 
+	/// @brief a 'size' rectangle centered on 'origin' and facing 'normal', solid behind it
 	struct Plane
 	{
 		using vector_type = Vector3;
@@ -191,6 +408,9 @@ namespace pphy
 		inline constexpr bool is_point_front( const Vector3 &vec ) const;
 		inline constexpr bool is_intersecting_line( const Vector3 &p0, const Vector3 &p1 ) const;
 
+		/// @brief the unit axes along the rectangle's sides, 'size.x' goes along 'side' and 'size.y' along 'forward'
+		inline void get_axes( Vector3 &side, Vector3 &forward ) const;
+
 		vector_type origin;
 		vector_type normal;
 		vector_type::lower_rank size;
@@ -209,6 +429,97 @@ namespace pphy
 	using Ray3D = TRay<Vector3>;
 	using Ray4D = TRay<Vector4>;
 
+	/// @brief a static triangle soup with a hierarchy over its triangles, for level geometry
+	/// @note shapes share it through 'Shape3D::set_mesh', don't edit a mesh that's already shared
+	class TriangleMesh
+	{
+	public:
+		using Face = std::array<uint32_t, 3>;
+		// triangles collide from both sides
+		static constexpr bool OneSided = false;
+
+		TriangleMesh() = default;
+		TriangleMesh( const std::vector<Vector3> &vertices, const std::vector<Face> &faces );
+
+		/// @brief replaces the triangles and rebuilds the hierarchy, faces index into 'vertices'
+		void set( const std::vector<Vector3> &vertices, const std::vector<Face> &faces );
+
+		/// @brief reads the 'v' and 'f' lines of a wavefront obj source, faces with more corners are fanned into triangles
+		/// @returns false if 'source' has no triangles
+		bool load_obj( const std::string &source );
+
+		inline const std::vector<Vector3> &get_vertices() const {
+			return m_vertices;
+		}
+
+		inline const std::vector<Face> &get_faces() const {
+			return m_faces;
+		}
+
+		inline const AABB &get_bounds() const {
+			return m_bounds;
+		}
+
+		/// @brief calls 'proc( a, b, c, face )' for the triangles around 'region', logarithmic in the triangle count
+		template <typename _PROC>
+		inline void query_triangles( const AABB &region, _PROC &&proc ) const;
+
+	private:
+		std::vector<Vector3> m_vertices;
+		std::vector<Face> m_faces;
+		AABB m_bounds = {};
+		TShapeTree<AABB> m_tree;
+	};
+
+	/// @brief a grid of heights over the xz plane, solid below its surface
+	/// @note sample (x, z) is at '(origin.x + x * spacing.x, height, origin.y + z * spacing.y)', every cell is split into two triangles
+	/// @note the bounds reach as far under the lowest sample as the grid is wide, bodies buried deeper than that are lost
+	class HeightField
+	{
+	public:
+		// triangles face up (counter-clockwise seen from above), anything under them gets pushed up
+		static constexpr bool OneSided = true;
+
+		HeightField() = default;
+		HeightField( index_t columns, index_t rows, const std::vector<real_t> &heights, const Vector2 &spacing, const Vector2 &origin = {} );
+
+		/// @brief replaces the grid, 'heights' holds 'columns * rows' samples row by row, missing ones are zero
+		void set( index_t columns, index_t rows, const std::vector<real_t> &heights, const Vector2 &spacing, const Vector2 &origin = {} );
+
+		/// @brief reads the 'v' lines of a wavefront obj source as the samples of a grid
+		/// @returns false if the vertices don't sit on a regular xz grid of at least 2x2 samples
+		bool load_obj( const std::string &source );
+
+		inline index_t get_columns() const {
+			return m_columns;
+		}
+
+		inline index_t get_rows() const {
+			return m_rows;
+		}
+
+		inline real_t get_height( index_t x, index_t z ) const {
+			return m_heights[ z * m_columns + x ];
+		}
+
+		inline const AABB &get_bounds() const {
+			return m_bounds;
+		}
+
+		/// @brief calls 'proc( a, b, c, face )' for the triangles of the cells under 'region'
+		/// @note a cell counts as solid all the way down, it's only skipped when 'region' is entirely above it
+		template <typename _PROC>
+		inline void query_triangles( const AABB &region, _PROC &&proc ) const;
+
+	private:
+		index_t m_columns = 0;
+		index_t m_rows = 0;
+		Vector2 m_spacing = { 1, 1 };
+		Vector2 m_origin = {};
+		std::vector<real_t> m_heights;
+		AABB m_bounds = {};
+	};
+
 	template <typename _VEC, typename _TENUM>
 	struct BaseShape
 	{
@@ -235,6 +546,9 @@ namespace pphy
 	public:
 		Shape2D();
 		Shape2D( shape_type_enum type );
+		Shape2D( const Shape2D &copy );
+		Shape2D &operator=( const Shape2D &other );
+		~Shape2D();
 
 		inline const Rect &get_rectangle() const noexcept {
 			return m_data.rectangle;
@@ -284,22 +598,35 @@ namespace pphy
 			return m_data.ray;
 		}
 
+		inline const Capsule2D &get_capsule() const noexcept {
+			return m_data.capsule;
+		}
+
+		inline Capsule2D &get_capsule() noexcept {
+			return m_data.capsule;
+		}
+
 		void recalculate_bounding_box();
 
 	private:
+		// the union doesn't know its active member, the owning shape passes its type in
 		union ShapeUnion2D
 		{
 			ShapeUnion2D( shape_type_enum type );
-			ShapeUnion2D( const ShapeUnion2D &copy );
-			ShapeUnion2D &operator=( const ShapeUnion2D &other );
+			ShapeUnion2D( shape_type_enum type, const ShapeUnion2D &copy );
+			ShapeUnion2D( const ShapeUnion2D &copy ) = delete;
+			ShapeUnion2D &operator=( const ShapeUnion2D &other ) = delete;
 			~ShapeUnion2D();
 
+			void destroy( shape_type_enum type );
+
 			Polygon2D polygon;
 			Circle circle;
 			Triangle triangle;
 			Line line;
 			Ray2D ray;
 			Rect rectangle;
+			Capsule2D capsule;
 		} m_data;
 	};
 
@@ -308,23 +635,111 @@ namespace pphy
 	public:
 		Shape3D();
 		Shape3D( shape_type_enum type );
+		/// @brief a Mesh shape sharing 'mesh'
+		Shape3D( const std::shared_ptr<const TriangleMesh> &mesh );
+		/// @brief a HeightField shape sharing 'height_field'
+		Shape3D( const std::shared_ptr<const HeightField> &height_field );
+		Shape3D( const Shape3D &copy );
+		Shape3D &operator=( const Shape3D &other );
+		~Shape3D();
+
+		inline const AABB &get_box() const noexcept {
+			return m_data.box;
+		}
+
+		inline AABB &get_box() noexcept {
+			return m_data.box;
+		}
+
+		inline const Polygon3D &get_polygon() const noexcept {
+			return m_data.polygon;
+		}
+
+		inline Polygon3D &get_polygon() noexcept {
+			return m_data.polygon;
+		}
+
+		inline const Sphere &get_sphere() const noexcept {
+			return m_data.sphere;
+		}
+
+		inline Sphere &get_sphere() noexcept {
+			return m_data.sphere;
+		}
+
+		inline const Pyramid &get_pyramid() const noexcept {
+			return m_data.pyramid;
+		}
+
+		inline Pyramid &get_pyramid() noexcept {
+			return m_data.pyramid;
+		}
+
+		inline const Plane &get_plane() const noexcept {
+			return m_data.plane;
+		}
+
+		inline Plane &get_plane() noexcept {
+			return m_data.plane;
+		}
+
+		inline const Ray3D &get_ray() const noexcept {
+			return m_data.ray;
+		}
+
+		inline Ray3D &get_ray() noexcept {
+			return m_data.ray;
+		}
+
+		inline const Capsule3D &get_capsule() const noexcept {
+			return m_data.capsule;
+		}
+
+		inline Capsule3D &get_capsule() noexcept {
+			return m_data.capsule;
+		}
+
+		/// @returns the shared mesh, null until 'set_mesh' and for the other shape types
+		inline const std::shared_ptr<const TriangleMesh> &get_mesh() const noexcept {
+			static const std::shared_ptr<const TriangleMesh> none{};
+			return m_type == ShapeType3D::Mesh ? m_data.mesh : none;
+		}
+
+		/// @brief turns the shape into a Mesh shape sharing 'mesh', whatever type it was
+		void set_mesh( const std::shared_ptr<const TriangleMesh> &mesh ) noexcept;
+
+		/// @returns the shared height field, null until 'set_height_field' and for the other shape types
+		inline const std::shared_ptr<const HeightField> &get_height_field() const noexcept {
+			static const std::shared_ptr<const HeightField> none{};
+			return m_type == ShapeType3D::HeightField ? m_data.height_field : none;
+		}
+
+		/// @brief turns the shape into a HeightField shape sharing 'height_field', whatever type it was
+		void set_height_field( const std::shared_ptr<const HeightField> &height_field ) noexcept;
 
 		void recalculate_bounding_box();
 
 	private:
+		// the union doesn't know its active member, the owning shape passes its type in
 		union ShapeUnion3D
 		{
 			ShapeUnion3D( shape_type_enum type );
-			ShapeUnion3D( const ShapeUnion3D &copy );
-			ShapeUnion3D &operator=( const ShapeUnion3D &other );
+			ShapeUnion3D( shape_type_enum type, const ShapeUnion3D &copy );
+			ShapeUnion3D( const ShapeUnion3D &copy ) = delete;
+			ShapeUnion3D &operator=( const ShapeUnion3D &other ) = delete;
 			~ShapeUnion3D();
 
+			void destroy( shape_type_enum type );
+
 			Polygon3D polygon;
 			Sphere sphere;
 			Pyramid pyramid;
 			Plane plane;
 			Ray3D ray;
 			AABB box;
+			Capsule3D capsule;
+			std::shared_ptr<const TriangleMesh> mesh;
+			std::shared_ptr<const HeightField> height_field;
 		} m_data;
 	};
 
@@ -378,17 +793,32 @@ namespace pphy
 		}
 
 		inline const vector_type &get_linear_velocity() const {
-			return m_position;
+			return m_linear_velocity;
 		}
 
 		inline real_t get_mass() const {
 			return m_mass;
 		}
 
+		inline real_t get_friction() const {
+			return m_friction;
+		}
+
+		inline real_t get_restitution() const {
+			return m_restitution;
+		}
+
 		void set_position( const vector_type &value );
 		void set_angle( real_t value );
 		void set_angular_velocity( real_t value );
 		void set_linear_velocity( const vector_type &value );
+		/// @note only Rigid and Charecter objects use their mass, zero or less is as heavy as a Static
+		void set_mass( real_t value );
+		/// @note a pair uses the geometric mean of its objects' frictions
+		void set_friction( real_t value );
+		/// @brief how much of the approach speed is kept when bouncing off, a pair uses the larger of its objects' restitutions
+		/// @note slow impacts don't bounce, resting objects would never settle
+		void set_restitution( real_t value );
 
 		inline void activate() {
 			wakeup();
@@ -403,10 +833,12 @@ namespace pphy
 			return m_active;
 		}
 
+		/// @returns the layers this object is on, one bit per layer
 		inline CollisionMask get_mask() const {
 			return m_mask;
 		}
 
+		/// @note which layers collide is decided by the space's layer matrix, see TSpace::set_layers_interact
 		void set_mask( CollisionMask mask );
 
 		inline void wakeup() {
@@ -450,8 +882,24 @@ namespace pphy
 			return m_frame_dirty;
 		}
 
+		inline const vector_type &get_sweep() const {
+			return m_sweep;
+		}
+
+		/// @brief stretches the frame over the shapes moved by 'displacement' too
+		/// @note the space sets it to the step's motion so the broadphase finds what fast objects are about to reach
+		void set_sweep( const vector_type &displacement );
+
+		/// @note call after editing shapes through 'get_shape', the shape tree is rebuilt with the frame
 		inline void invalidate_frame() {
 			m_frame_dirty = true;
+			m_shape_tree_dirty = true;
+		}
+
+		/// @returns the hierarchy over the shapes, empty for objects with less than 'TShapeTree::MinimumShapes' shapes
+		/// @note valid after 'recalculate_frame'
+		inline const TShapeTree<frame_type> &get_shape_tree() const {
+			return m_shape_tree;
 		}
 
 		void recalculate_frame();
@@ -466,11 +914,18 @@ namespace pphy
 		vector_type m_linear_velocity;
 		real_t m_angular_velocity;
 		real_t m_mass;
+		real_t m_friction;
+		real_t m_restitution;
 		CollisionMask m_mask;
 
 		frame_type m_frame;
 		bool m_frame_dirty = true;
+		vector_type m_sweep;
 		shapes_container m_shapes;
+
+		// only rebuilt when the shapes change
+		TShapeTree<frame_type> m_shape_tree;
+		bool m_shape_tree_dirty = true;
 	};
 	using Object2D = TObject<ObjectState2D>;
 	using Object3D = TObject<ObjectState3D>;
@@ -478,88 +933,1208 @@ namespace pphy
 	using ObjectBatch = std::vector<index_t>;
 	using BatchResult = std::vector<ObjectBatch>;
 
+	// a pair of object indices, the first index is always the smaller one
+	using ObjectPair = std::pair<index_t, index_t>;
+	using PairList = std::vector<ObjectPair>;
+
+	/// @brief narrowphase state of one overlapping pair, kept with the pair in the pair cache between steps
+	struct ContactCache
+	{
+		static constexpr uint16_t NoFeature = 0xffff;
+
+		// last separating (or least penetrating) axis, the normal of edge 'axis_edge' of the first (0) or second (1) shape
+		// a hint only, objects with several shapes share it
+		uint16_t axis_owner = NoFeature;
+		uint16_t axis_edge = NoFeature;
+
+		// search directions of the last GJK simplex, supporting along them again seeds the next run
+		uint8_t simplex_count = 0;
+		real_t simplex[ 4 ][ 3 ] = {};
+	};
+
+	/// @brief contact points between two shapes, the normal points from the first shape to the second
+	template <typename _VEC, index_t _MAX_POINTS>
+	struct TManifold
+	{
+		using vector_type = _VEC;
+		static constexpr index_t MaxPoints = _MAX_POINTS;
+
+		struct Point
+		{
+			vector_type position;
+			real_t depth;
+			// the features that made this point, points with the same id in consecutive steps are the same contact
+			uint32_t id = 0;
+			// accumulated along 'normal' by the solver, carried over to the next step's point with the same id
+			real_t normal_impulse = 0;
+			// accumulated across 'normal' by the friction, carried over with 'normal_impulse'
+			vector_type tangent_impulse{};
+		};
+
+		vector_type normal;
+		Point points[ MaxPoints ];
+		index_t point_count = 0;
+
+		inline real_t get_depth() const {
+			real_t depth = 0;
+			for (index_t i = 0; i < point_count; i++)
+			{
+				depth = std::max( depth, points[ i ].depth );
+			}
+			return depth;
+		}
+	};
+	using Manifold2D = TManifold<Vector2, 2>;
+	using Manifold3D = TManifold<Vector3, 4>;
+
+	// the manifold for shapes in '_VEC' space
+	template <typename _VEC>
+	using ManifoldOf = std::conditional_t<std::is_same_v<_VEC, Vector2>, Manifold2D, Manifold3D>;
+
 	namespace batchers
 	{
 
-		template <typename _OBJ>
-		class TBoundsBatcher
+		/// @brief union-find over object indices, turns linked pairs into disjoint islands
+		/// @note fixed (static) objects are attached to islands without joining them, a static floor doesn't
+		/// glue every body on it into one island; an attached object may show up in several islands
+		class IslandBuilder
 		{
 		public:
-			using object_type = _OBJ;
-			using frame_type = typename object_type::frame_type;
-			TBoundsBatcher();
+			static constexpr index_t NoIsland = static_cast<index_t>(-1);
 
-			inline const BatchResult &get_results() const {
-				return m_results;
-			}
+			/// @brief forgets every link and prepares for 'object_count' objects
+			void reset( size_t object_count );
 
-			void invalidate();
+			/// @brief puts 'a' and 'b' in the same island (overlapping frames, contacts, ...)
+			void link( index_t a, index_t b );
 
-			inline void try_rebuild( const std::vector<object_type> &objects ) {
-				if (m_dirty)
-					rebuild( objects );
-			}
+			/// @brief adds 'fixed' to the island of 'body' without merging anything else
+			void attach( index_t fixed, index_t body );
 
-			void rebuild( const std::vector<object_type> &objects );
+			/// @returns the representative of the island 'index' is linked into
+			index_t find( index_t index );
+
+			/// @brief writes the islands into 'islands', largest first
+			/// @note an island lists its linked members in index order, then the objects attached to it in index order
+			/// objects never linked nor attached to are left out, the batches in 'islands' are reused
+			void build( BatchResult &islands );
+
+			/// @returns the island 'index' ended up in by the last build, NoIsland for attached and untouched objects
+			inline index_t get_island( index_t index ) {
+				return m_touched[ index ] ? m_lookup[ find( index ) ] : NoIsland;
+			}
 
 		private:
-			bool m_dirty = true;
-			BatchResult m_results;
-			real_t m_expand_margin = 0.25f;
+			std::vector<index_t> m_parents;
+			std::vector<index_t> m_sizes;
+			std::vector<uint8_t> m_touched;
+			std::vector<ObjectPair> m_attachments;
+			std::vector<index_t> m_lookup;
+			// per island in discovery order, its root, its size with the attached objects, and the islands by size
+			std::vector<index_t> m_roots;
+			std::vector<index_t> m_counts;
+			std::vector<index_t> m_order;
+			// batches past the island count of earlier builds, reused before allocating new ones
+			BatchResult m_spare;
 		};
-		using BoundsBatcher2D = TBoundsBatcher<Object2D>;
-		using BoundsBatcher3D = TBoundsBatcher<Object3D>;
 
-	}
+		/// @brief the members of a batch sharing one layer bucket, [begin, end) of the batch
+		struct BucketRun
+		{
+			index_t bucket;
+			index_t begin;
+			index_t end;
+		};
 
-	namespace solvers
-	{
-		/*
-		Solvers are static classes with an object template
-		they also have a solve functions which:
-			has objects param
-			has shapes param (planning to use multi-shape objects later down the line)
-			returns weather there was a collision
-		*/
+		/// @brief sorts objects into buckets of equal collision masks, so a batcher can test two buckets against each
+		/// other or skip them whole when their layers never meet
+		/// @note an object only changes bucket when its mask does, buckets are never dropped since a scene only
+		/// uses a handful of masks
+		class LayerBuckets
+		{
+		public:
+			static constexpr index_t NullBucket = static_cast<index_t>(-1);
+			LayerBuckets();
+
+			/// @brief recomputes which buckets meet, objects keep their buckets
+			void set_matrix( const LayerMatrix &matrix );
+
+			/// @returns the bucket of 'mask', adding it if no object had the mask yet
+			index_t find( CollisionMask mask );
+
+			/// @brief moves 'index' to the bucket of 'mask'
+			/// @returns the bucket 'index' was in, NullBucket if none
+			index_t assign( index_t index, CollisionMask mask );
+
+			/// @brief forgets every object's bucket
+			void clear();
+
+			inline index_t get_bucket( index_t index ) const {
+				return index < m_objects.size() ? m_objects[ index ] : NullBucket;
+			}
+
+			/// @returns true if 'index' isn't in the bucket of 'mask' (yet)
+			inline bool is_stale( index_t index, CollisionMask mask ) const {
+				const index_t bucket = get_bucket( index );
+				return bucket == NullBucket || m_masks[ bucket ] != mask;
+			}
+
+			/// @returns true if objects of bucket 'a' can collide with objects of bucket 'b'
+			inline bool meet( index_t a, index_t b ) const {
+				return (m_reaches[ a ] & m_masks[ b ]) != 0;
+			}
 
+			inline size_t size() const {
+				return m_masks.size();
+			}
+
+		private:
+			inline CollisionMask get_reach( CollisionMask mask ) const;
+
+		private:
+			LayerMatrix m_matrix;
+			// per bucket mask and the layers it collides with
+			std::vector<CollisionMask> m_masks;
+			std::vector<CollisionMask> m_reaches;
+			// per object bucket
+			std::vector<index_t> m_objects;
+		};
+
+		/// @brief overlapping pairs kept between steps
+		/// @note the pairs are a flat array sorted by object indices, each update merges in the broadphase's
+		/// pairs and records which pairs began and ended overlapping
 		template <typename _OBJ>
-		class TIterative
+		class TPairCache
 		{
 		public:
 			using object_type = _OBJ;
-			using shape_type = typename object_type::shape_type;
-			using shape_type_enum = typename object_type::shape_type_enum;
-			using object_type_enum = ObjectType;
+			using manifold_type = ManifoldOf<typename object_type::vector_type>;
+
+			// the touching points of shape 'shape_a' of the first object and shape 'shape_b' of the second
+			struct Contact
+			{
+				uint16_t shape_a;
+				uint16_t shape_b;
+				manifold_type manifold;
+			};
+
+			struct Entry
+			{
+				ObjectPair pair;
+				// consecutive steps this pair has been overlapping, 1 on the step it began
+				uint32_t frames;
+				ContactCache cache;
+				// one per touching shape pair, rebuilt every step with the impulses of matching points carried over
+				std::vector<Contact> contacts;
+			};
+
+			TPairCache();
+
+			/// @brief merges this step's pairs into the cache
+			/// @param pairs sorted and unique pairs overlapping this step
+			void update( const PairList &pairs );
+
+			void clear();
+
+			inline const std::vector<Entry> &get_entries() const {
+				return m_entries;
+			}
 
-			using object_ref_pair = std::pair<object_type &, object_type &>;
-			using shape_ref_pair = std::pair<const shape_type &, const shape_type &>;
+			inline std::vector<Entry> &get_entries() {
+				return m_entries;
+			}
 
-			typedef bool(*SolverProc)(object_ref_pair, shape_ref_pair);
+			/// @returns the pairs that started overlapping in the last update
+			inline const PairList &get_began() const {
+				return m_began;
+			}
 
-			template<shape_type_enum ShapeTypeA, shape_type_enum ShapeTypeB>
-			static bool solve( object_ref_pair objects, shape_ref_pair shapes );
+			/// @returns the pairs that stopped overlapping in the last update
+			inline const PairList &get_ended() const {
+				return m_ended;
+			}
 
+		private:
+			std::vector<Entry> m_entries;
+			std::vector<Entry> m_merged;
+			PairList m_began;
+			PairList m_ended;
 		};
-		using Iterative2D = TIterative<Object2D>;
+		using PairCache2D = TPairCache<Object2D>;
+		using PairCache3D = TPairCache<Object3D>;
 
-	}
+		/// @brief dynamic bounding volume tree keyed by object index
+		/// @note leaves hold fattened frames, a key whose frame stays inside its fat frame is never touched
+		template <typename _FRAME>
+		class TDynamicTree
+		{
+		public:
+			using frame_type = _FRAME;
+			using value_type = typename frame_type::value_type;
+			static constexpr index_t NullNode = static_cast<index_t>(-1);
 
-	template <typename _OBJ>
-	class TSpace
-	{
-	public:
-		using object_type = _OBJ;
-		using batcher_type = batchers::TBoundsBatcher<object_type>;
-		friend batcher_type;
+			TDynamicTree( value_type margin = 0.25f );
 
-		TSpace();
+			/// @brief inserts 'key' with 'frame' fattened by the margin, O(log n)
+			void insert( index_t key, const frame_type &frame );
 
-		void update( real_t deltatime );
+			/// @brief reinserts 'key' if 'frame' left its fat frame, O(log n)
+			/// @returns true if the tree changed
+			bool move( index_t key, const frame_type &frame );
 
-		/// @brief adds the object to the object list
-		/// @note will invalidate batcher which in turn is pretty expensive
-		void add_object( const object_type &object );
-		inline const object_type &get_object( index_t index ) const {
+			/// @brief removes 'key' from the tree, O(log n)
+			void remove( index_t key );
+
+			void clear();
+
+			inline bool contains( index_t key ) const {
+				return key < m_leaves.size() && m_leaves[ key ] != NullNode;
+			}
+
+			inline const frame_type &get_fat_frame( index_t key ) const {
+				return m_nodes[ m_leaves[ key ] ].frame;
+			}
+
+			inline size_t size() const {
+				return m_count;
+			}
+
+			inline index_t get_height() const {
+				return m_root == NullNode ? 0 : m_nodes[ m_root ].height;
+			}
+
+			/// @brief calls 'proc( key )' for every key whose fat frame intersects 'region'
+			/// @note 'proc' returns false to stop the query
+			template <typename _PROC>
+			inline void query( const frame_type &region, _PROC &&proc ) const;
+
+			/// @brief appends every pair of keys with intersecting fat frames to 'pairs'
+			void query_pairs( PairList &pairs ) const;
+
+			/// @brief appends every pair of a key of this tree and a key of 'other' with intersecting fat frames to 'pairs',
+			/// smaller key first
+			/// @note walks this tree's leaves, call it on the smaller tree
+			void query_pairs( const TDynamicTree &other, PairList &pairs ) const;
+
+		private:
+			struct Node
+			{
+				frame_type frame;
+				// next free node when the node is in the free list
+				index_t parent;
+				index_t left;
+				index_t right;
+				index_t key;
+				int32_t height;
+			};
+
+			inline bool is_leaf( index_t node ) const {
+				return m_nodes[ node ].left == NullNode;
+			}
+
+			index_t allocate_node();
+			void free_node( index_t node );
+
+			void insert_leaf( index_t leaf );
+			void remove_leaf( index_t leaf );
+			void refit( index_t node );
+			index_t balance( index_t node );
+
+		private:
+			std::vector<Node> m_nodes;
+			// key -> leaf node
+			std::vector<index_t> m_leaves;
+			index_t m_root = NullNode;
+			index_t m_free_list = NullNode;
+			size_t m_count = 0;
+			value_type m_margin;
+		};
+		using DynamicTree2D = TDynamicTree<Rect>;
+		using DynamicTree3D = TDynamicTree<AABB>;
+
+		/// @brief groups objects by their expanded frames
+		/// @note groups are maintained incrementally, only the objects queued through 'mark_moved' are looked at and only
+		/// the ones leaving their expanded frame get re-homed
+		/// @note a group is only swept again once as many members left it as are still in it, until then it may hold
+		/// objects that no longer touch, which costs candidate tests but never misses a pair
+		/// @note objects only join a group through objects their layers meet, inside a group the members are kept in one
+		/// run per layer bucket, see 'get_runs'
+		template <typename _OBJ>
+		class TBoundsBatcher
+		{
+		public:
+			using object_type = _OBJ;
+			using frame_type = typename object_type::frame_type;
+			static constexpr index_t NoGroup = static_cast<index_t>(-1);
+			TBoundsBatcher();
+
+			/// @note groups emptied by merges and removals stay as empty batches until a new group reuses them
+			inline const BatchResult &get_results() const {
+				return m_results;
+			}
+
+			/// @returns the layer bucket runs of 'group's batch, a pair of runs whose buckets don't meet never collides
+			inline const std::vector<BucketRun> &get_runs( index_t group ) const {
+				return m_group_runs[ group ];
+			}
+
+			inline const LayerBuckets &get_buckets() const {
+				return m_buckets;
+			}
+
+			/// @brief drops every group, the next rebuild regroups all objects
+			void invalidate();
+
+			/// @brief sets which layers interact, the groups are rebuilt on the next rebuild
+			void set_layer_matrix( const LayerMatrix &matrix );
+
+			/// @brief puts the object in the group its frame hits, merging the groups if it hits several
+			void add_object( index_t index, const object_type &object );
+
+			/// @brief takes the object out of its group, splitting the group if it falls apart
+			/// @note meant for deactivated objects, try_rebuild puts active objects back
+			void remove_object( index_t index );
+
+			/// @brief re-homes the object if its frame left the expanded frame it was grouped with
+			/// @returns true if the object was re-homed
+			bool update_object( index_t index, const object_type &object );
+
+			/// @brief queues the object for the next try_rebuild, its frame changed or it was (de)activated
+			void mark_moved( index_t index );
+
+			/// @returns true if the object has to be queued, call it before the object's frame is recalculated
+			inline bool needs_update( index_t index, const object_type &object ) const;
+
+			inline index_t get_group( index_t index ) const {
+				return index < m_groups.size() ? m_groups[ index ] : NoGroup;
+			}
+
+			// full rebuild when invalidated, otherwise only the queued objects are touched
+			void try_rebuild( const std::vector<object_type> &objects );
+
+			/// @brief regroups every object, the overlap sweep runs on the thread pool if there is one
+			/// @note groups are numbered by their lowest member, so the grouping doesn't depend on the thread count
+			void rebuild( const std::vector<object_type> &objects );
+
+			/// @brief the pool full rebuilds run on, null runs them on the calling thread
+			inline void set_thread_pool( IThreadPool *pool ) {
+				m_thread_pool = pool;
+			}
+
+		private:
+			void insert( index_t index, const frame_type &frame );
+			index_t allocate_group( const frame_type &frame );
+			void free_group( index_t group );
+			void split_group( index_t group );
+			// adds 'index' to the end of its bucket's run in 'group'
+			void push_member( index_t group, index_t index );
+			// takes 'index' out of its group's batch, the group is left as is otherwise
+			void pop_member( index_t index );
+			// true if any member of 'group' can collide with objects of 'bucket'
+			inline bool group_meets( index_t group, index_t bucket ) const;
+
+		private:
+			bool m_dirty = true;
+			BatchResult m_results;
+			real_t m_expand_margin = 0.25f;
+
+			// per object expanded frame, group and place in the group's batch
+			std::vector<frame_type> m_frames;
+			std::vector<index_t> m_groups;
+			std::vector<index_t> m_positions;
+
+			// the objects queued for the next try_rebuild
+			std::vector<index_t> m_moved;
+			std::vector<uint8_t> m_moved_flags;
+
+			// per group frame and the members that left it since it was last swept, the tree is keyed by group index
+			std::vector<frame_type> m_group_frames;
+			std::vector<size_t> m_group_removals;
+			std::vector<std::vector<BucketRun>> m_group_runs;
+			LayerBuckets m_buckets;
+			// group indices with empty batches, waiting to be reused
+			std::vector<index_t> m_free_groups;
+			TDynamicTree<frame_type> m_group_tree;
+
+			std::vector<index_t> m_hits;
+			std::vector<index_t> m_components;
+			IslandBuilder m_islands;
+
+			IThreadPool *m_thread_pool = nullptr;
+			// rebuild scratch, the batched objects sorted on x and the overlaps each chunk of them found
+			// 'm_order' also holds the members of a group being split
+			std::vector<index_t> m_order;
+			std::vector<PairList> m_chunk_pairs;
+		};
+		using BoundsBatcher2D = TBoundsBatcher<Object2D>;
+		using BoundsBatcher3D = TBoundsBatcher<Object3D>;
+
+		/// @brief sort-and-sweep broadphase over the objects' expanded frames
+		/// @note the sorted axis list is kept between rebuilds, so coherent frames only cost an insertion sort pass
+		/// @note every layer bucket has its own axis, two axes are only swept against each other if their layers meet
+		template <typename _OBJ>
+		class TSweepBatcher
+		{
+		public:
+			using object_type = _OBJ;
+			using frame_type = typename object_type::frame_type;
+			using value_type = typename frame_type::value_type;
+			TSweepBatcher();
+
+			inline const BatchResult &get_results() const {
+				return m_results;
+			}
+
+			/// @returns the overlapping pairs found by the last rebuild, grouped by bucket pair and in sweep order within one
+			inline const PairList &get_pairs() const {
+				return m_pairs;
+			}
+
+			void invalidate();
+
+			/// @brief sets which layers interact, the axes stay as they are
+			inline void set_layer_matrix( const LayerMatrix &matrix ) {
+				m_buckets.set_matrix( matrix );
+			}
+
+			inline void add_object( index_t index, const object_type &object ) {
+				(void)index;
+				(void)object;
+				invalidate();
+			}
+
+			// objects move every step, so the sweep always runs; 'invalidate' only resyncs the axis list
+			inline void try_rebuild( const std::vector<object_type> &objects ) {
+				rebuild( objects );
+			}
+
+			void rebuild( const std::vector<object_type> &objects );
+
+		private:
+			struct Endpoint
+			{
+				value_type value;
+				index_t index;
+			};
+
+			void sync_axis( const std::vector<object_type> &objects );
+			// puts 'index' on the axis of the bucket of 'mask'
+			void push_endpoint( index_t index, CollisionMask mask );
+			static void sort_axis( std::vector<Endpoint> &axis );
+			// reports the pairs of bucket 'a' and bucket 'b', the same bucket sweeps against itself
+			void sweep( const std::vector<object_type> &objects, index_t a, index_t b );
+
+		private:
+			bool m_dirty = true;
+			BatchResult m_results;
+			PairList m_pairs;
+			real_t m_expand_margin = 0.25f;
+
+			// per layer bucket begin points of the dynamic objects on the x axis, sorted ascending
+			std::vector<std::vector<Endpoint>> m_axes;
+			LayerBuckets m_buckets;
+			// how many of the space's objects the axes have seen
+			size_t m_synced_count = 0;
+			std::vector<frame_type> m_frames;
+			// per bucket frames in axis order, swept several at a time
+			std::vector<TFrameSoA<frame_type>> m_sorted_frames;
+			// objects whose mask changed, waiting for their new axis
+			std::vector<index_t> m_restaged;
+			IslandBuilder m_islands;
+		};
+		using SweepBatcher2D = TSweepBatcher<Object2D>;
+		using SweepBatcher3D = TSweepBatcher<Object3D>;
+
+		/// @brief broadphase on top of TDynamicTree
+		/// @note objects are inserted as they are added, only objects leaving their fat frames are reinserted
+		/// @note every layer bucket has its own tree, two trees are only queried against each other if their layers meet
+		template <typename _OBJ>
+		class TTreeBatcher
+		{
+		public:
+			using object_type = _OBJ;
+			using frame_type = typename object_type::frame_type;
+			using tree_type = TDynamicTree<frame_type>;
+			TTreeBatcher();
+
+			inline const BatchResult &get_results() const {
+				return m_results;
+			}
+
+			inline const PairList &get_pairs() const {
+				return m_pairs;
+			}
+
+			/// @returns the trees indexed by layer bucket
+			inline const std::vector<tree_type> &get_trees() const {
+				return m_trees;
+			}
+
+			/// @brief drops the trees, every active object is reinserted on the next rebuild
+			void invalidate();
+
+			/// @brief sets which layers interact, the trees stay as they are
+			void set_layer_matrix( const LayerMatrix &matrix );
+
+			void add_object( index_t index, const object_type &object );
+
+			// cheap when nothing left its fat frame
+			inline void try_rebuild( const std::vector<object_type> &objects ) {
+				rebuild( objects );
+			}
+
+			void rebuild( const std::vector<object_type> &objects );
+
+		private:
+			// inserts 'index' in the tree of its mask's bucket
+			void insert( index_t index, const object_type &object );
+
+		private:
+			bool m_dirty = true;
+			bool m_changed = false;
+			BatchResult m_results;
+			PairList m_pairs;
+			real_t m_expand_margin = 0.25f;
+			std::vector<tree_type> m_trees;
+			LayerBuckets m_buckets;
+
+			IslandBuilder m_islands;
+		};
+		using TreeBatcher2D = TTreeBatcher<Object2D>;
+		using TreeBatcher3D = TTreeBatcher<Object3D>;
+
+		/// @brief linear bounding volume hierarchy over AABBs, built by sorting the centroids on 30-bit morton codes
+		/// @note meant for scenes loaded all at once, moving leaves are refit in O(n) and the hierarchy is
+		/// rebuilt once refitting made it too loose
+		class LinearBVH
+		{
+		public:
+			using frame_type = AABB;
+			using value_type = frame_type::value_type;
+			static constexpr index_t NullNode = static_cast<index_t>(-1);
+
+			/// @brief builds the hierarchy over 'frames', leaf 'i' is keyed 'keys[ i ]'
+			/// @param pool runs the codes, the sort and the hierarchy, null builds on the calling thread
+			void build( const std::vector<index_t> &keys, const std::vector<frame_type> &frames, IThreadPool *pool = nullptr );
+
+			/// @brief updates the frame of 'key', takes effect on the next refit
+			inline void set_frame( index_t key, const frame_type &frame ) {
+				m_nodes[ m_leaves[ key ] ].frame = frame;
+			}
+
+			/// @brief recomputes every inner frame from the leaves, O(n)
+			/// @returns false if the hierarchy degraded past the rebuild ratio and should be rebuilt
+			bool refit();
+
+			inline bool contains( index_t key ) const {
+				return key < m_leaves.size() && m_leaves[ key ] != NullNode;
+			}
+
+			inline size_t size() const {
+				return m_leaf_count;
+			}
+
+			/// @returns the summed inner node surface area relative to the one right after the build
+			inline value_type get_quality() const {
+				return m_build_cost > 0 ? m_cost / m_build_cost : 1;
+			}
+
+			inline void set_rebuild_ratio( value_type ratio ) {
+				m_rebuild_ratio = ratio;
+			}
+
+			/// @brief calls 'proc( key )' for every key whose frame intersects 'region'
+			/// @note 'proc' returns false to stop the query
+			template <typename _PROC>
+			inline void query( const frame_type &region, _PROC &&proc ) const;
+
+			/// @brief appends every pair of keys with intersecting frames to 'pairs'
+			void query_pairs( PairList &pairs ) const;
+
+			/// @brief appends every pair of a key of this hierarchy and a key of 'other' with intersecting frames to 'pairs',
+			/// smaller key first
+			/// @note walks this hierarchy's leaves, call it on the smaller one
+			void query_pairs( const LinearBVH &other, PairList &pairs ) const;
+
+		private:
+			struct Node
+			{
+				frame_type frame;
+				index_t left;
+				index_t right;
+				// the key for leaves
+				index_t key;
+			};
+
+			struct MortonLeaf
+			{
+				uint32_t code;
+				index_t input;
+
+				inline bool operator<( const MortonLeaf &other ) const {
+					return code < other.code || (code == other.code && input < other.input);
+				}
+			};
+
+			// common prefix length of the sorted codes 'i' and 'j', -1 when 'j' is out of range
+			inline int32_t common_prefix( int64_t i, int64_t j ) const;
+			void build_inner_node( index_t index );
+
+		private:
+			// inner nodes are [0, n - 1), leaves are [n - 1, 2n - 1)
+			std::vector<Node> m_nodes;
+			// key -> node
+			std::vector<index_t> m_leaves;
+			// inner nodes with every child before its parent
+			std::vector<index_t> m_refit_order;
+			std::vector<MortonLeaf> m_sorted;
+			size_t m_leaf_count = 0;
+			value_type m_cost = 0;
+			value_type m_build_cost = 0;
+			value_type m_rebuild_ratio = 2;
+		};
+
+		/// @brief broadphase on top of LinearBVH, refits every step and rebuilds when the hierarchy degrades
+		/// @note every layer bucket has its own hierarchy, two hierarchies are only queried against each other if their
+		/// layers meet
+		class LinearBVHBatcher3D
+		{
+		public:
+			using object_type = Object3D;
+			using frame_type = AABB;
+			LinearBVHBatcher3D();
+
+			inline const BatchResult &get_results() const {
+				return m_results;
+			}
+
+			inline const PairList &get_pairs() const {
+				return m_pairs;
+			}
+
+			/// @returns the hierarchies indexed by layer bucket
+			inline const std::vector<LinearBVH> &get_bvhs() const {
+				return m_bvhs;
+			}
+
+			/// @brief the pool the bulk builds run on, null builds on the calling thread
+			inline void set_thread_pool( IThreadPool *pool ) {
+				m_thread_pool = pool;
+			}
+
+			/// @brief rebuilds the hierarchies from scratch on the next rebuild
+			void invalidate();
+
+			/// @brief sets which layers interact, the hierarchies stay as they are
+			inline void set_layer_matrix( const LayerMatrix &matrix ) {
+				m_buckets.set_matrix( matrix );
+			}
+
+			inline void add_object( index_t index, const object_type &object ) {
+				(void)index;
+				(void)object;
+				invalidate();
+			}
+
+			inline void try_rebuild( const std::vector<object_type> &objects ) {
+				rebuild( objects );
+			}
+
+			void rebuild( const std::vector<object_type> &objects );
+
+		private:
+			bool m_dirty = true;
+			BatchResult m_results;
+			PairList m_pairs;
+			real_t m_expand_margin = 0.25f;
+			IThreadPool *m_thread_pool = nullptr;
+			std::vector<LinearBVH> m_bvhs;
+			LayerBuckets m_buckets;
+
+			// per bucket keys and frames of the last build
+			std::vector<std::vector<index_t>> m_keys;
+			std::vector<std::vector<AABB>> m_frames;
+			// activity at the last build, a change needs a rebuild
+			std::vector<uint8_t> m_active;
+			IslandBuilder m_islands;
+		};
+
+		/// @brief hashed uniform grid broadphase, best for crowds of similar sized objects
+		/// @note the cell size is derived from the median circle radius unless set explicitly
+		/// @note bucket storage only grows, steady frames don't allocate
+		/// @note objects covering more than 'MaxObjectCells' cells (long lines, huge or far away frames) stay out of the grid
+		/// and are tested against every other object instead
+		class HashGridBatcher2D
+		{
+		public:
+			using object_type = Object2D;
+			using frame_type = Rect;
+			static constexpr int64_t MaxObjectCells = 64;
+			HashGridBatcher2D();
+
+			inline const BatchResult &get_results() const {
+				return m_results;
+			}
+
+			inline const PairList &get_pairs() const {
+				return m_pairs;
+			}
+
+			inline real_t get_cell_size() const {
+				return m_used_cell_size;
+			}
+
+			/// @brief sets a fixed cell size, zero or less derives it from the median circle radius
+			void set_cell_size( real_t size );
+
+			/// @brief rederives the cell size on the next rebuild
+			void invalidate();
+
+			/// @brief sets which layers interact
+			inline void set_layer_matrix( const LayerMatrix &matrix ) {
+				m_buckets.set_matrix( matrix );
+			}
+
+			inline void add_object( index_t index, const object_type &object ) {
+				(void)index;
+				(void)object;
+				invalidate();
+			}
+
+			inline void try_rebuild( const std::vector<object_type> &objects ) {
+				rebuild( objects );
+			}
+
+			void rebuild( const std::vector<object_type> &objects );
+
+		private:
+			struct Entry
+			{
+				Vector2i cell;
+				index_t index;
+				// the object's layer bucket, entries whose buckets don't meet are never frame tested
+				index_t bucket;
+			};
+
+			void recalculate_cell_size( const std::vector<object_type> &objects );
+			inline Vector2i get_cell( const Vector2 &point ) const;
+			inline size_t hash_cell( const Vector2i &cell ) const;
+
+		private:
+			bool m_dirty = true;
+			BatchResult m_results;
+			PairList m_pairs;
+			real_t m_expand_margin = 0.25f;
+			real_t m_cell_size = 0;
+			real_t m_used_cell_size = 1;
+
+			std::vector<Rect> m_frames;
+			std::vector<Entry> m_entries;
+			std::vector<Entry> m_sorted_entries;
+			// the objects too big for the grid
+			std::vector<index_t> m_oversized;
+			// bucket 'i' spans [m_bucket_starts[i], m_bucket_starts[i + 1]) of the sorted entries
+			std::vector<size_t> m_bucket_starts;
+			std::vector<size_t> m_bucket_fill;
+			std::vector<real_t> m_radii;
+			LayerBuckets m_buckets;
+			IslandBuilder m_islands;
+		};
+
+		/// @brief loose octree over AABBs, cells are created on demand and recycled once empty, so sparse worlds only
+		/// pay for the occupied space
+		/// @note a key lives in the deepest cell at least as big as its frame, the cell containing the frame's center,
+		/// the cell's loose bounds are twice its size so the key stays put until it moves half a cell
+		class LooseOctree
+		{
+		public:
+			using frame_type = AABB;
+			using value_type = frame_type::value_type;
+			static constexpr index_t NullNode = static_cast<index_t>(-1);
+
+			/// @param max_depth deepest cell level, capped at 30
+			LooseOctree( uint32_t max_depth = 10 );
+
+			/// @brief drops every key and roots the tree at the smallest cube around 'world'
+			void reset( const frame_type &world );
+
+			void clear();
+
+			/// @brief inserts 'key' in the cell fitting 'frame', O(depth)
+			/// @note keys centered outside of the root cell are kept at the root, see 'get_escaped_count'
+			void insert( index_t key, const frame_type &frame );
+
+			/// @brief updates the frame of 'key', only reinserting it once it leaves its cell's loose bounds
+			/// or shrinks enough to fit a child cell
+			/// @note O(1) while 'key' stays in its cell, O(depth) when it changes cells
+			/// @returns true if 'key' changed cells
+			bool move( index_t key, const frame_type &frame );
+
+			/// @brief removes 'key' from its cell and frees the cells it leaves empty, O(depth)
+			void remove( index_t key );
+
+			inline bool contains( index_t key ) const {
+				return key < m_items.size() && m_items[ key ].node != NullNode;
+			}
+
+			inline size_t size() const {
+				return m_count;
+			}
+
+			inline uint32_t get_max_depth() const {
+				return m_max_depth;
+			}
+
+			/// @returns the keys centered outside of the root cell, the tree wants a 'reset' once there are any
+			inline size_t get_escaped_count() const {
+				return m_escaped;
+			}
+
+			/// @brief calls 'proc( key )' for every key whose frame intersects 'region'
+			/// @note 'proc' returns false to stop the query
+			template <typename _PROC>
+			inline void query( const frame_type &region, _PROC &&proc ) const;
+
+			/// @brief appends every pair of keys with intersecting frames to 'pairs'
+			/// @note each key only looks at the cells down to its own depth, the deeper key of a pair is the one finding it
+			/// only occupied cells are visited
+			void query_pairs( PairList &pairs ) const;
+
+			/// @brief appends every pair of a key of this tree and a key of 'other' with intersecting frames to 'pairs',
+			/// smaller key first
+			/// @note walks this tree's keys, call it on the smaller tree
+			void query_pairs( const LooseOctree &other, PairList &pairs ) const;
+
+			/// @returns the cells in use, empty cells are recycled
+			inline size_t get_node_count() const {
+				return m_nodes.size() - m_free_nodes.size();
+			}
+
+		private:
+			struct Node
+			{
+				Vector3 center;
+				// half the cell size, the loose bounds reach a full cell size from the center
+				value_type extent;
+				uint32_t depth;
+				index_t parent;
+				index_t children[ 8 ];
+				// intrusive list of the keys in this cell
+				index_t first;
+				// keys in this cell and every cell below it
+				size_t count;
+			};
+
+			struct Item
+			{
+				frame_type frame;
+				index_t node;
+				index_t prev;
+				index_t next;
+				// centered outside of the root cell
+				bool escaped;
+			};
+
+			inline frame_type get_loose_bounds( const Node &node ) const;
+			// the cell 'frame' belongs to, creating the missing cells on the way
+			index_t find_node( const frame_type &frame );
+			index_t create_node( index_t parent, uint32_t child );
+			void link( index_t key, index_t node );
+			// unlinks 'key' and frees the cells left empty
+			void unlink( index_t key );
+			// true if 'frame' is centered outside of 'node's cell or too big for its loose bounds
+			inline bool is_outside( const Node &node, const frame_type &frame ) const;
+			// true if 'frame' left 'node's loose bounds or is small enough for one of its children
+			inline bool is_misplaced( const Node &node, const frame_type &frame ) const;
+
+		private:
+			std::vector<Node> m_nodes;
+			// freed cells, reused before 'm_nodes' grows
+			std::vector<index_t> m_free_nodes;
+			std::vector<Item> m_items;
+			uint32_t m_max_depth;
+			size_t m_count = 0;
+			size_t m_escaped = 0;
+		};
+
+		/// @brief broadphase on top of LooseOctree, for large and sparse worlds with clustered objects
+		/// @note moving objects are only reinserted when they leave their cell, the tree is re-rooted when objects
+		/// leave the world bounds it was built for
+		/// @note every layer bucket has its own tree, two trees are only queried against each other if their layers meet
+		class LooseOctreeBatcher3D
+		{
+		public:
+			using object_type = Object3D;
+			using frame_type = AABB;
+			LooseOctreeBatcher3D();
+
+			inline const BatchResult &get_results() const {
+				return m_results;
+			}
+
+			inline const PairList &get_pairs() const {
+				return m_pairs;
+			}
+
+			/// @returns the trees indexed by layer bucket
+			inline const std::vector<LooseOctree> &get_octrees() const {
+				return m_octrees;
+			}
+
+			/// @brief re-roots the trees on the next rebuild
+			void invalidate();
+
+			/// @brief sets which layers interact, the trees stay as they are
+			inline void set_layer_matrix( const LayerMatrix &matrix ) {
+				m_buckets.set_matrix( matrix );
+			}
+
+			/// @brief inserts the object right away, unless the tree is waiting to be re-rooted
+			void add_object( index_t index, const object_type &object );
+
+			// the octree keeps its cells between steps, only moved objects are touched
+			void try_rebuild( const std::vector<object_type> &objects );
+
+			void rebuild( const std::vector<object_type> &objects );
+
+		private:
+			// inserts 'index' in the tree of its mask's bucket
+			void insert( index_t index, const object_type &object );
+			void update_pairs( size_t object_count );
+			bool has_escaped() const;
+
+		private:
+			bool m_dirty = true;
+			BatchResult m_results;
+			PairList m_pairs;
+			std::vector<LooseOctree> m_octrees;
+			LayerBuckets m_buckets;
+			IslandBuilder m_islands;
+		};
+
+	}
+
+	namespace solvers
+	{
+		/*
+		Solvers are static classes with an object template
+		they also have a solve functions which:
+			has objects param
+			has shapes param (planning to use multi-shape objects later down the line)
+			fills the manifold param, the space solves the contacts
+			returns weather there was a collision
+		*/
+
+		template <typename _OBJ>
+		class TIterative
+		{
+		public:
+			using object_type = _OBJ;
+			using shape_type = typename object_type::shape_type;
+			using shape_type_enum = typename object_type::shape_type_enum;
+			using object_type_enum = ObjectType;
+
+			using object_ref_pair = std::pair<const object_type &, const object_type &>;
+			using shape_ref_pair = std::pair<const shape_type &, const shape_type &>;
+			using manifold_type = ManifoldOf<typename object_type::vector_type>;
+
+			typedef bool(*SolverProc)(object_ref_pair, shape_ref_pair, ContactCache &, manifold_type &);
+			// 'reach' is the furthest apart the shapes may be, see 'separate'
+			typedef bool(*SeparationProc)(object_ref_pair, shape_ref_pair, real_t, ContactCache &, manifold_type &);
+
+			static constexpr index_t ShapeTypeCount = static_cast<index_t>(shape_type_enum::Count);
+
+			template<shape_type_enum ShapeTypeA, shape_type_enum ShapeTypeB>
+			static bool solve( object_ref_pair objects, shape_ref_pair shapes, ContactCache &cache, manifold_type &manifold );
+
+			/// @returns true if there is a routine for exactly this order of shape types
+			template<shape_type_enum ShapeTypeA, shape_type_enum ShapeTypeB>
+			static constexpr bool is_implemented();
+
+			/// @returns the routine for the shape types of 'shapes', a lookup in a table generated at compile time
+			/// @note pairs only implemented the other way around get a routine swapping the arguments,
+			/// pairs with no routine at all get one that never collides
+			static inline SolverProc get_solver( shape_type_enum type_a, shape_type_enum type_b );
+
+			/// @brief the speculative counterpart of 'solve', for shapes that don't touch yet
+			/// @returns true and one point at the closest points if the shapes are less than 'reach' apart,
+			/// the point's depth is minus the gap, shapes that touch are left to 'solve'
+			template<shape_type_enum ShapeTypeA, shape_type_enum ShapeTypeB>
+			static bool separate( object_ref_pair objects, shape_ref_pair shapes, real_t reach, ContactCache &cache, manifold_type &manifold );
+
+			/// @returns true if there is a 'separate' routine for exactly this order of shape types
+			template<shape_type_enum ShapeTypeA, shape_type_enum ShapeTypeB>
+			static constexpr bool is_separable();
+
+			/// @returns the 'separate' routine for the shape types, swapped and fallback routines just like 'get_solver'
+			static inline SeparationProc get_separation( shape_type_enum type_a, shape_type_enum type_b );
+
+		};
+		using Iterative2D = TIterative<Object2D>;
+		using Iterative3D = TIterative<Object3D>;
+
+		/// @brief circle pairs packed as structure of arrays, lane 'i' holds the world space circles of the 'i'th pair
+		struct CirclePairs
+		{
+			inline size_t size() const {
+				return pairs.size();
+			}
+
+			inline void clear();
+			inline void push_back( index_t pair, const Circle &a, const Circle &b );
+
+			std::vector<real_t> a_x, a_y, a_radius;
+			std::vector<real_t> b_x, b_y, b_radius;
+			// the caller's index for every lane, copied to its contact
+			std::vector<index_t> pairs;
+		};
+
+		struct CircleContact
+		{
+			index_t pair;
+			// points from the first circle to the second
+			Vector2 normal;
+			real_t depth;
+		};
+
+		/// @brief one contact point as the velocity solver sees it, the space packs them into a flat array every step
+		/// @note bodies don't rotate, so a point only needs the inverse masses of its objects
+		template <typename _VEC>
+		struct TContactConstraint
+		{
+			using vector_type = _VEC;
+			using point_type = typename ManifoldOf<vector_type>::Point;
+
+			index_t body_a;
+			index_t body_b;
+			// points from 'body_a' to 'body_b'
+			vector_type normal;
+			// 1 / (inverse mass a + inverse mass b), the same along the normal and across it
+			real_t mass;
+			real_t friction;
+			real_t restitution;
+			// how fast the objects may still approach, closes the gap of speculative points in one step
+			real_t approach;
+			// the normal velocity before solving, restitution bounces off it
+			real_t relative_velocity;
+			// overlap the split impulse pushes out, zero for speculative points
+			real_t depth;
+
+			real_t normal_impulse;
+			vector_type tangent_impulse;
+			real_t position_impulse;
+
+			// the manifold point the impulses are written back to for the next step's warm start
+			point_type *point;
+		};
+		using ContactConstraint2D = TContactConstraint<Vector2>;
+		using ContactConstraint3D = TContactConstraint<Vector3>;
+
+		/// @brief contact constraints repacked as structure of arrays, 'simd::SimdWidth' lanes per group
+		/// @note no movable object is in two lanes of one group, so a group's rows are solved at once and written back
+		/// without conflicts, statics can be in any number of lanes since their velocity never changes
+		/// the constraints that don't fill a group are left to the caller's scalar loop, see 'get_tail'
+		template <typename _VEC>
+		class TWideContacts
+		{
+		public:
+			using vector_type = _VEC;
+			using constraint_type = TContactConstraint<vector_type>;
+			static constexpr index_t dimensions = TFrame<vector_type>::dimensions;
+
+			/// @brief groups 'constraints', 'inverse_masses' holds one entry per object the constraints point into
+			void pack( const std::vector<constraint_type> &constraints, const std::vector<real_t> &inverse_masses );
+
+			/// @brief one pass of the normal and friction rows over every group, the same update as the scalar solver
+			/// @returns the largest squared change of any impulse
+			real_t solve( std::vector<vector_type> &velocities );
+
+			/// @brief writes the accumulated impulses of the groups back to the constraints they were packed from
+			void unpack( std::vector<constraint_type> &constraints ) const;
+
+			inline size_t get_group_count() const {
+				return m_group_count;
+			}
+
+			/// @returns the indices of the constraints that didn't make it into a group, in their original order
+			inline const std::vector<index_t> &get_tail() const {
+				return m_tail;
+			}
+
+		private:
+			// emits the lanes of slot 'slot' as the next group
+			void emit_group( const std::vector<constraint_type> &constraints, const std::vector<real_t> &inverse_masses, index_t slot );
+
+		private:
+			size_t m_group_count = 0;
+
+			// lane 'i' of group 'g' is at 'g * simd::SimdWidth + i' of every array
+			// offsets of the objects' velocities in reals, what simd::gather takes
+			std::vector<int32_t> m_offsets_a;
+			std::vector<int32_t> m_offsets_b;
+			std::vector<real_t> m_inverse_masses_a;
+			std::vector<real_t> m_inverse_masses_b;
+			std::array<std::vector<real_t>, dimensions> m_normals;
+			std::vector<real_t> m_masses;
+			std::vector<real_t> m_frictions;
+			std::vector<real_t> m_approaches;
+			std::vector<real_t> m_normal_impulses;
+			std::array<std::vector<real_t>, dimensions> m_tangent_impulses;
+			// the constraint every lane was packed from
+			std::vector<index_t> m_sources;
+
+			std::vector<index_t> m_tail;
+
+			// packing scratch, constraints wait in one of 32 slots for a group to fill up
+			// per object the bits of the slots it's waiting in
+			std::vector<uint32_t> m_object_slots;
+			// slot 's' holds its lanes at 's * simd::SimdWidth', kept out of the layout so it doesn't depend on the build flags
+			std::vector<index_t> m_slot_lanes;
+			std::array<index_t, 32> m_slot_counts;
+		};
+		using WideContacts2D = TWideContacts<Vector2>;
+		using WideContacts3D = TWideContacts<Vector3>;
+
+		/// @brief tests all the lanes of 'circles', 'simd::SimdWidth' of them at a time
+		/// @note only the overlapping lanes get a normal and a depth, they're appended to 'contacts' in lane order
+		void collide_circles( const CirclePairs &circles, std::vector<CircleContact> &contacts );
+
+	}
+
+	/// @brief the physics world
+	/// @param _BATCHER the broadphase, one of batchers::TBoundsBatcher, batchers::TSweepBatcher, batchers::TTreeBatcher
+	/// batchers::HashGridBatcher2D, batchers::LinearBVHBatcher3D or batchers::LooseOctreeBatcher3D
+	template <typename _OBJ, typename _BATCHER = batchers::TBoundsBatcher<_OBJ>>
+	class TSpace
+	{
+	public:
+		using object_type = _OBJ;
+		using frame_type = typename object_type::frame_type;
+		using batcher_type = _BATCHER;
+		using pair_cache_type = batchers::TPairCache<object_type>;
+		using solver_type = solvers::TIterative<object_type>;
+		friend batcher_type;
+
+		// one per bit of CollisionMask
+		static constexpr index_t LayerCount = sizeof( CollisionMask ) * 8;
+
+		TSpace();
+
+		void update( real_t deltatime );
+
+		/// @brief adds the object to the object list
+		/// @note the bounds and sweep batchers get invalidated, the tree batcher only inserts the object
+		/// @note static objects go in the static tree instead and never reach the batcher
+		void add_object( const object_type &object );
+
+		/// @brief reinserts a static object into the static tree after it was moved or (de)activated
+		/// @note statics are never re-batched, this is the only way the static tree picks up changes
+		void update_static( index_t index );
+
+		/// @brief takes a static object out of the static tree and deactivates it, the index stays valid
+		void remove_static( index_t index );
+
+		inline const object_type &get_object( index_t index ) const {
 			return m_objects[ index ];
 		}
 
@@ -567,16 +2142,148 @@ namespace pphy
 			return m_objects[ index ];
 		}
 
+		inline const batcher_type &get_batcher() const {
+			return m_batcher;
+		}
+
+		/// @returns the islands solved by the last update, largest first
+		/// @note islands never share a non-static object, so each can be solved on its own thread
+		inline const BatchResult &get_islands() const {
+			return m_islands;
+		}
+
+		inline const pair_cache_type &get_pair_cache() const {
+			return m_pair_cache;
+		}
+
+		/// @brief runs the frame preprocessor, the batcher's rebuilds and the pair collection on 'pool'
+		/// @note the pool is not owned and has to outlive the space or be reset to null, passing null goes back to one thread
+		void set_thread_pool( IThreadPool *pool );
+
+		inline IThreadPool *get_thread_pool() const {
+			return m_thread_pool;
+		}
+
+		/// @brief sets whether objects on 'layer_a' and objects on 'layer_b' can collide, both ways
+		/// @note every layer interacts with every layer by default, layers past 'LayerCount' are ignored
+		/// @note batchers taking a layer matrix get the new one right away and skip the layer pairs that never meet
+		void set_layers_interact( index_t layer_a, index_t layer_b, bool interact );
+
+		/// @returns the layers that 'layer' collides with, none for layers past 'LayerCount'
+		inline CollisionMask get_layer_interactions( index_t layer ) const {
+			return layer < LayerCount ? m_layer_matrix[ layer ] : 0;
+		}
+
+		/// @returns true if an object masked 'mask_a' can collide with one masked 'mask_b'
+		inline bool can_interact( CollisionMask mask_a, CollisionMask mask_b ) const {
+			return (get_reach( mask_a ) & mask_b) != 0;
+		}
+
+		/// @brief sets whether frames are swept along the objects' velocities, so pairs that would meet during the step
+		/// get contacts before they touch, on by default
+		/// @note a speculative contact only stops the part of the approach that would close its gap, fast objects
+		/// can't pass through thin walls without a time of impact solve
+		void set_speculative_contacts( bool enabled );
+
+		inline bool get_speculative_contacts() const {
+			return m_speculative;
+		}
+
+		/// @brief sets whether large islands solve their contacts 'simd::SimdWidth' at a time, on by default
+		/// @note the results match the scalar solver's up to the order the contacts are visited in
+		void set_wide_solver( bool enabled );
+
+		inline bool get_wide_solver() const {
+			return m_wide_solver;
+		}
+
 	private:
-		void update( const ObjectBatch &objects );
+		// per chunk scratch of the parallel loops
+		struct PairChunk
+		{
+			PairList pairs;
+			TFrameSoA<frame_type> frames;
+			// objects the preprocessor found moved, for batchers that only look at those
+			ObjectBatch moved;
+		};
+
+		// every layer the layers in 'mask' interact with
+		inline CollisionMask get_reach( CollisionMask mask ) const;
+
+	private:
+		void collect_pairs();
+		void build_islands();
+		/// @brief how far the pair's objects close in on each other this step, zero without speculative contacts
+		inline real_t get_sweep( const ObjectPair &pair ) const;
+		/// @brief rebuilds the contacts of the island's pairs
+		void collide_island( index_t island );
+		/// @note 2D only, the island pairs [begin, end) of 'm_island_pairs'
+		void collide_island_circles( size_t begin, size_t end );
+		/// @brief packs the island's contact points into 'm_constraints' and runs the velocity and position passes over them
+		void solve_island( index_t island );
+		/// @brief applies 'impulse' (pointing from the first object to the second) between the objects 'a' and 'b'
+		inline void apply_impulse( index_t a, index_t b, const typename object_type::vector_type &impulse );
+		/// @brief one pass of the normal and friction rows of 'constraint'
+		/// @returns the largest squared change of its impulses
+		inline real_t solve_contact( solvers::TContactConstraint<typename object_type::vector_type> &constraint );
+		/// @brief the same for the pseudo velocities that only move the objects apart
+		inline void apply_position_impulse( index_t a, index_t b, const typename object_type::vector_type &impulse );
 
 	private:
 		real_t m_dt;
 		batcher_type m_batcher;
 		std::vector<object_type> m_objects;
+
+		// statics, built as they are added and only changed through update_static/remove_static
+		batchers::TDynamicTree<frame_type> m_static_tree;
+
+		IThreadPool *m_thread_pool = nullptr;
+		// candidate pairs per chunk of the parallel loops, merged into 'm_pairs' in chunk order
+		std::vector<PairChunk> m_chunks;
+
+		// row 'i' holds the layers layer 'i' interacts with, kept symmetric
+		LayerMatrix m_layer_matrix;
+		// per object reach of its mask, refreshed by the preprocessor
+		std::vector<CollisionMask> m_reach;
+
+		bool m_speculative = true;
+		bool m_wide_solver = true;
+
+		PairList m_pairs;
+		pair_cache_type m_pair_cache;
+
+		batchers::IslandBuilder m_island_builder;
+		BatchResult m_islands;
+		// cached pair indices grouped by island, island 'i' owns [m_island_pair_starts[i], m_island_pair_starts[i + 1])
+		std::vector<index_t> m_island_pairs;
+		std::vector<size_t> m_island_pair_starts;
+		std::vector<size_t> m_island_pair_fill;
+
+		// the island's circle against circle shape pairs, collided as one batch
+		solvers::CirclePairs m_circle_pairs;
+		std::vector<solvers::CircleContact> m_circle_contacts;
+
+		// per object, gathered by the preprocessor, the solver works on these and writes the velocities back
+		std::vector<typename object_type::vector_type> m_velocities;
+		// split impulse, moves the objects out of each other for one step without keeping any speed
+		std::vector<typename object_type::vector_type> m_pseudo_velocities;
+		std::vector<real_t> m_inverse_masses;
+		// the contact points of the island being solved
+		std::vector<solvers::TContactConstraint<typename object_type::vector_type>> m_constraints;
+		// 'm_constraints' packed for the wide solver, large islands only
+		solvers::TWideContacts<typename object_type::vector_type> m_wide_contacts;
+		// the contacts of the pair being collided
+		std::vector<typename pair_cache_type::Contact> m_pair_contacts;
 	};
 	using Space2D = TSpace<Object2D>;
 	using Space3D = TSpace<Object3D>;
+	using SweepSpace2D = TSpace<Object2D, batchers::SweepBatcher2D>;
+	using SweepSpace3D = TSpace<Object3D, batchers::SweepBatcher3D>;
+	using TreeSpace2D = TSpace<Object2D, batchers::TreeBatcher2D>;
+	using TreeSpace3D = TSpace<Object3D, batchers::TreeBatcher3D>;
+	using HashGridSpace2D = TSpace<Object2D, batchers::HashGridBatcher2D>;
+	using LBVHSpace3D = TSpace<Object3D, batchers::LinearBVHBatcher3D>;
+	using OctreeSpace3D = TSpace<Object3D, batchers::LooseOctreeBatcher3D>;
 
 #pragma region(Definitions)
 
@@ -592,12 +2299,12 @@ namespace pphy
 
 	template<>
 	inline constexpr bool TFrame<Vector2>::intersects( const this_type &other ) const {
-		return other.end.x < begin.x || other.end.y < begin.y || other.begin.x > end.x || other.begin.y > end.y;
+		return !(other.end.x < begin.x || other.end.y < begin.y || other.begin.x > end.x || other.begin.y > end.y);
 	}
 
 	template<>
 	inline constexpr bool TFrame<Vector3>::intersects( const this_type &other ) const {
-		return other.end.x < begin.x || other.end.y < begin.y || other.end.z < begin.z || other.begin.x > end.x || other.begin.y > end.y || other.begin.z > end.z;
+		return !(other.end.x < begin.x || other.end.y < begin.y || other.end.z < begin.z || other.begin.x > end.x || other.begin.y > end.y || other.begin.z > end.z);
 	}
 
 	template<>
@@ -610,6 +2317,28 @@ namespace pphy
 		return { begin.x - margin, begin.y - margin, begin.z - margin, end.x + margin, end.y + margin, end.z + margin };
 	}
 
+	template<>
+	inline constexpr bool TFrame<Vector2>::contains( const this_type &other ) const {
+		return begin.x <= other.begin.x && begin.y <= other.begin.y && other.end.x <= end.x && other.end.y <= end.y;
+	}
+
+	template<>
+	inline constexpr bool TFrame<Vector3>::contains( const this_type &other ) const {
+		return begin.x <= other.begin.x && begin.y <= other.begin.y && begin.z <= other.begin.z
+			&& other.end.x <= end.x && other.end.y <= end.y && other.end.z <= end.z;
+	}
+
+	template<>
+	inline constexpr TFrame<Vector2>::value_type TFrame<Vector2>::measure() const {
+		return 2 * ((end.x - begin.x) + (end.y - begin.y));
+	}
+
+	template<>
+	inline constexpr TFrame<Vector3>::value_type TFrame<Vector3>::measure() const {
+		const vector_type size = end - begin;
+		return 2 * ((size.x * size.y) + (size.y * size.z) + (size.z * size.x));
+	}
+
 	template<>
 	inline constexpr void TFrame<Vector2>::encase( const this_type &other ) {
 		begin.x = std::min( begin.x, other.begin.x );
@@ -646,6 +2375,154 @@ namespace pphy
 		end.z = std::max( end.z, other.z );
 	}
 
+	template<typename _FRAME>
+	inline void TFrameSoA<_FRAME>::resize( size_t count ) {
+		// lanes read past the last frame, the padding has to be there and be empty
+		const size_t padded = count + simd::SimdWidth;
+		const size_t old_padded = m_count + simd::SimdWidth;
+		for (index_t axis = 0; axis < dimensions; axis++)
+		{
+			m_begins[ axis ].resize( padded, std::numeric_limits<value_type>::max() );
+			m_ends[ axis ].resize( padded, std::numeric_limits<value_type>::lowest() );
+		}
+
+		m_count = count;
+
+		// shrinking leaves old frames in what is now padding
+		for (index_t index = count; index < old_padded && index < padded; index++)
+		{
+			set_empty( index );
+		}
+	}
+
+	template<typename _FRAME>
+	inline void TFrameSoA<_FRAME>::set_empty( index_t index ) {
+		for (index_t axis = 0; axis < dimensions; axis++)
+		{
+			m_begins[ axis ][ index ] = std::numeric_limits<value_type>::max();
+			m_ends[ axis ][ index ] = std::numeric_limits<value_type>::lowest();
+		}
+	}
+
+	template<typename _FRAME>
+	inline uint32_t TFrameSoA<_FRAME>::overlap_mask( const frame_type &frame, index_t first ) const {
+		const value_type *begins[ dimensions ];
+		const value_type *ends[ dimensions ];
+		for (index_t axis = 0; axis < dimensions; axis++)
+		{
+			begins[ axis ] = m_begins[ axis ].data();
+			ends[ axis ] = m_ends[ axis ].data();
+		}
+
+		return simd::overlap_mask<dimensions>( begins, ends, first, &frame.begin.x, &frame.end.x );
+	}
+
+	template<typename _FRAME>
+	template<typename _PROC>
+	inline void TFrameSoA<_FRAME>::for_each_overlap( const frame_type &frame, index_t first, index_t last, _PROC &&proc ) const {
+		for (index_t chunk = first; chunk < last; chunk += simd::SimdWidth)
+		{
+			uint32_t mask = overlap_mask( frame, chunk );
+
+			// the chunk may run past 'last'
+			if (last - chunk < simd::SimdWidth)
+				mask &= (1u << (last - chunk)) - 1u;
+
+			while (mask)
+			{
+				const uint32_t lane = simd::lowest_bit( mask );
+				mask &= mask - 1u;
+				proc( chunk + lane );
+			}
+		}
+	}
+
+	template<typename _VEC>
+	inline constexpr typename TFrame<_VEC>::vector_type TFrame<_VEC>::support( const vector_type &direction ) const {
+		vector_type corner = begin;
+		for (index_t i = 0; i < dimensions; i++)
+		{
+			if ((&direction.x)[ i ] > 0)
+				(&corner.x)[ i ] = (&end.x)[ i ];
+		}
+		return corner;
+	}
+
+	template<typename _VEC>
+	inline typename TPolygon<_VEC>::vector_type TPolygon<_VEC>::support( const vector_type &direction ) const {
+		index_t best = 0;
+		for (index_t i = 1; i < m_points.size(); i++)
+		{
+			if (m_points[ i ].dot( direction ) > m_points[ best ].dot( direction ))
+				best = i;
+		}
+		return m_points.empty() ? vector_type{} : m_points[ best ];
+	}
+
+	template<typename _VEC>
+	inline typename TRound<_VEC>::vector_type TRound<_VEC>::support( const vector_type &direction ) const {
+		const auto length = direction.length();
+		if (length <= 0)
+			return center;
+		return center + direction * (radius / length);
+	}
+
+	template<typename _VEC>
+	inline typename TCapsule<_VEC>::vector_type TCapsule<_VEC>::support( const vector_type &direction ) const {
+		const vector_type &tip = direction.dot( end - start ) > 0 ? end : start;
+		const auto length = direction.length();
+		if (length <= 0)
+			return tip;
+		return tip + direction * (radius / length);
+	}
+
+	template<typename _VEC>
+	inline typename TCapsule<_VEC>::vector_type TCapsule<_VEC>::closest_point( const vector_type &point ) const {
+		const vector_type segment = end - start;
+		const auto length_squared = segment.length_squared();
+		if (length_squared <= 0)
+			return start;
+		return start + segment * std::clamp<real_t>( segment.dot( point - start ) / length_squared, 0, 1 );
+	}
+
+	template<>
+	inline Vector2 TPointy<Vector2>::support( const Vector2 &direction ) const {
+		const Vector2 half_base = head_extent.normalized().tangent() * (base_size * real_t( 0.5 ));
+		const Vector2 corners[ 3 ] = { base + head_extent, base + half_base, base - half_base };
+
+		index_t best = 0;
+		for (index_t i = 1; i < 3; i++)
+		{
+			if (corners[ i ].dot( direction ) > corners[ best ].dot( direction ))
+				best = i;
+		}
+		return corners[ best ];
+	}
+
+	template<>
+	inline Vector3 TPointy<Vector3>::support( const Vector3 &direction ) const {
+		// any two axes perpendicular to the tip span the base
+		const Vector3 up = head_extent.normalized();
+		const Vector3 side = (std::abs( up.x ) < real_t( 0.9 ) ? Vector3{ 1, 0, 0 } : Vector3{ 0, 1, 0 }).cross( up ).normalized();
+		const Vector3 forward = up.cross( side );
+		const Vector3 half_side = side * (base_size.x * real_t( 0.5 ));
+		const Vector3 half_forward = forward * (base_size.y * real_t( 0.5 ));
+
+		const Vector3 corners[ 5 ] = {
+			base + head_extent,
+			base + half_side + half_forward, base + half_side - half_forward,
+			base - half_side + half_forward, base - half_side - half_forward
+		};
+
+		index_t best = 0;
+		for (index_t i = 1; i < 5; i++)
+		{
+			if (corners[ i ].dot( direction ) > corners[ best ].dot( direction ))
+				best = i;
+		}
+		return corners[ best ];
+	}
+
 	template <typename _VEC>
 	inline constexpr bool TRound<_VEC>::is_point_inside( const vector_type &point ) const {
 		return (point - center).length_squared() <= radius;
@@ -680,6 +2557,158 @@ namespace pphy
 		return false;
 	}
 
+	template<typename _FRAME>
+	template<typename _PROC>
+	inline void TShapeTree<_FRAME>::query( const frame_type &region, _PROC &&proc ) const {
+		if (m_nodes.empty())
+			return;
+
+		// one pending sibling per level plus the two children just pushed
+		index_t stack[ MaxDepth + 1 ];
+		index_t stack_size = 0;
+		stack[ stack_size++ ] = 0;
+		while (stack_size > 0)
+		{
+			const Node &node = m_nodes[ stack[ --stack_size ] ];
+			if (!node.frame.intersects( region ))
+				continue;
+
+			if (node.count > 0)
+			{
+				for (index_t i = 0; i < node.count; i++)
+				{
+					proc( m_shapes[ node.first + i ] );
+				}
+				continue;
+			}
+
+			stack[ stack_size++ ] = node.first + 1;
+			stack[ stack_size++ ] = node.first;
+		}
+	}
+
+	template<typename _FRAME>
+	template<typename _PROC>
+	inline void TShapeTree<_FRAME>::query_pairs( const TShapeTree &other, const vector_type &offset, real_t reach, _PROC &&proc ) const {
+		if (m_nodes.empty() || other.m_nodes.empty())
+			return;
+
+		// every descent goes one level down one of the trees and leaves one pending sibling
+		std::pair<index_t, index_t> stack[ 2 * MaxDepth + 1 ];
+		index_t stack_size = 0;
+		stack[ stack_size++ ] = { 0, 0 };
+		while (stack_size > 0)
+		{
+			const auto [ index, other_index ] = stack[ --stack_size ];
+			const Node &node = m_nodes[ index ];
+			const Node &other_node = other.m_nodes[ other_index ];
+
+			frame_type other_frame = other_node.frame.expanded( reach );
+			other_frame.begin += offset;
+			other_frame.end += offset;
+			if (!node.frame.intersects( other_frame ))
+				continue;
+
+			if (node.count > 0 && other_node.count > 0)
+			{
+				for (index_t i = 0; i < node.count; i++)
+				{
+					for (index_t j = 0; j < other_node.count; j++)
+					{
+						proc( m_shapes[ node.first + i ], other.m_shapes[ other_node.first + j ] );
+					}
+				}
+				continue;
+			}
+
+			// descends the inner node with the bigger frame first
+			if (other_node.count > 0 || (node.count == 0 && node.frame.measure() >= other_node.frame.measure()))
+			{
+				stack[ stack_size++ ] = { node.first + 1, other_index };
+				stack[ stack_size++ ] = { node.first, other_index };
+			}
+			else
+			{
+				stack[ stack_size++ ] = { index, other_node.first + 1 };
+				stack[ stack_size++ ] = { index, other_node.first };
+			}
+		}
+	}
+
+	template<typename _PROC>
+	inline void TriangleMesh::query_triangles( const AABB &region, _PROC &&proc ) const {
+		m_tree.query(
+			region,
+			[ this, &proc ]( const index_t face ) {
+				const Face &corners = m_faces[ face ];
+				proc( m_vertices[ corners[ 0 ] ], m_vertices[ corners[ 1 ] ], m_vertices[ corners[ 2 ] ], face );
+			}
+		);
+	}
+
+	template<typename _PROC>
+	inline void HeightField::query_triangles( const AABB &region, _PROC &&proc ) const {
+		if (m_columns < 2 || m_rows < 2 || !m_bounds.intersects( region ))
+			return;
+
+		// the cells under the region, clamped to the grid
+		const auto cell = []( real_t position, real_t origin, real_t spacing, index_t count ) {
+			const real_t index = std::floor( (position - origin) / spacing );
+			return static_cast<index_t>(std::clamp( index, real_t( 0 ), static_cast<real_t>(count - 2) ));
+		};
+		const index_t begin_x = cell( region.begin.x, m_origin.x, m_spacing.x, m_columns );
+		const index_t end_x = cell( region.end.x, m_origin.x, m_spacing.x, m_columns );
+		const index_t begin_z = cell( region.begin.z, m_origin.y, m_spacing.y, m_rows );
+		const index_t end_z = cell( region.end.z, m_origin.y, m_spacing.y, m_rows );
+
+		for (index_t z = begin_z; z <= end_z; z++)
+		{
+			for (index_t x = begin_x; x <= end_x; x++)
+			{
+				const real_t heights[ 4 ] = { get_height( x, z ), get_height( x + 1, z ), get_height( x, z + 1 ), get_height( x + 1, z + 1 ) };
+				if (*std::max_element( heights, heights + 4 ) < region.begin.y)
+					continue;
+
+				const real_t begin_x_position = m_origin.x + x * m_spacing.x;
+				const real_t begin_z_position = m_origin.y + z * m_spacing.y;
+				const Vector3 corner_00{ begin_x_position, heights[ 0 ], begin_z_position };
+				const Vector3 corner_10{ begin_x_position + m_spacing.x, heights[ 1 ], begin_z_position };
+				const Vector3 corner_01{ begin_x_position, heights[ 2 ], begin_z_position + m_spacing.y };
+				const Vector3 corner_11{ begin_x_position + m_spacing.x, heights[ 3 ], begin_z_position + m_spacing.y };
+
+				const index_t face = (z * (m_columns - 1) + x) * 2;
+				proc( corner_00, corner_01, corner_11, face );
+				proc( corner_00, corner_11, corner_10, face + 1 );
+			}
+		}
+	}
+
+	inline void solvers::CirclePairs::clear() {
+		a_x.clear();
+		a_y.clear();
+		a_radius.clear();
+		b_x.clear();
+		b_y.clear();
+		b_radius.clear();
+		pairs.clear();
+	}
+
+	inline void solvers::CirclePairs::push_back( index_t pair, const Circle &a, const Circle &b ) {
+		a_x.push_back( a.center.x );
+		a_y.push_back( a.center.y );
+		a_radius.push_back( a.radius );
+		b_x.push_back( b.center.x );
+		b_y.push_back( b.center.y );
+		b_radius.push_back( b.radius );
+		pairs.push_back( pair );
+	}
+
+	inline void Plane::get_axes( Vector3 &side, Vector3 &forward ) const {
+		const Vector3 up = normal.normalized();
+		side = (std::abs( up.x ) < real_t( 0.9 ) ? Vector3{ 1, 0, 0 } : Vector3{ 0, 1, 0 }).cross( up ).normalized();
+		forward = up.cross( side );
+	}
+
 	template<>
 	inline TObject<ObjectState2D>::frame_type TObject<ObjectState2D>::get_frame() const {
 		return m_frame;
@@ -690,6 +2719,126 @@ namespace pphy
 		return m_frame;
 	}
 
+	template<typename _FRAME>
+	template<typename _PROC>
+	inline void batchers::TDynamicTree<_FRAME>::query( const frame_type &region, _PROC &&proc ) const {
+		if (m_root == NullNode)
+			return;
+
+		// the tree is balanced, so the stack never gets close to this
+		index_t stack[ 256 ];
+		size_t stack_size = 0;
+		stack[ stack_size++ ] = m_root;
+
+		while (stack_size > 0)
+		{
+			const Node &node = m_nodes[ stack[ --stack_size ] ];
+			if (!node.frame.intersects( region ))
+				continue;
+
+			if (node.left == NullNode)
+			{
+				if (!proc( node.key ))
+					return;
+				continue;
+			}
+
+			stack[ stack_size++ ] = node.left;
+			stack[ stack_size++ ] = node.right;
+		}
+	}
+
+	template<typename _OBJ, typename _BATCHER>
+	inline CollisionMask TSpace<_OBJ, _BATCHER>::get_reach( CollisionMask mask ) const {
+		CollisionMask reach = 0;
+		while (mask)
+		{
+			reach |= m_layer_matrix[ simd::lowest_bit( mask ) ];
+			mask &= mask - 1u;
+		}
+		return reach;
+	}
+
+	template<typename _PROC>
+	inline void batchers::LooseOctree::query( const frame_type &region, _PROC &&proc ) const {
+		if (m_nodes.empty())
+			return;
+
+		index_t stack[ 256 ];
+		size_t stack_size = 0;
+		stack[ stack_size++ ] = 0;
+
+		while (stack_size > 0)
+		{
+			const Node &node = m_nodes[ stack[ --stack_size ] ];
+
+			for (index_t key = node.first; key != NullNode; key = m_items[ key ].next)
+			{
+				if (m_items[ key ].frame.intersects( region ) && !proc( key ))
+					return;
+			}
+
+			for (const index_t child : node.children)
+			{
+				// every level leaves at most 7 siblings behind, the capped depth keeps this well inside the stack
+				if (child != NullNode && m_nodes[ child ].count > 0 && get_loose_bounds( m_nodes[ child ] ).intersects( region ))
+					stack[ stack_size++ ] = child;
+			}
+		}
+	}
+
+	inline batchers::LooseOctree::frame_type batchers::LooseOctree::get_loose_bounds( const Node &node ) const {
+		const Vector3 reach = { node.extent * 2, node.extent * 2, node.extent * 2 };
+		return { node.center - reach, node.center + reach };
+	}
+
+	inline bool batchers::LooseOctree::is_outside( const Node &node, const frame_type &frame ) const {
+		const Vector3 center = (frame.begin + frame.end) * value_type( 0.5 );
+		const Vector3 size = frame.end - frame.begin;
+
+		return std::abs( center.x - node.center.x ) > node.extent
+			|| std::abs( center.y - node.center.y ) > node.extent
+			|| std::abs( center.z - node.center.z ) > node.extent
+			|| std::max( std::max( size.x, size.y ), size.z ) > node.extent * 2;
+	}
+
+	inline bool batchers::LooseOctree::is_misplaced( const Node &node, const frame_type &frame ) const {
+		if (!get_loose_bounds( node ).contains( frame ))
+			return true;
+
+		// small enough for a child cell
+		const Vector3 size = frame.end - frame.begin;
+		return node.depth < m_max_depth && std::max( std::max( size.x, size.y ), size.z ) <= node.extent;
+	}
+
+	template<typename _PROC>
+	inline void batchers::LinearBVH::query( const frame_type &region, _PROC &&proc ) const {
+		if (m_leaf_count == 0)
+			return;
+
+		// depth is bounded by the 30 code bits plus the duplicate tie breaking
+		index_t stack[ 256 ];
+		size_t stack_size = 0;
+		stack[ stack_size++ ] = 0;
+
+		while (stack_size > 0)
+		{
+			const Node &node = m_nodes[ stack[ --stack_size ] ];
+			if (!node.frame.intersects( region ))
+				continue;
+
+			if (node.left == NullNode)
+			{
+				if (!proc( node.key ))
+					return;
+				continue;
+			}
+
+			stack[ stack_size++ ] = node.left;
+			stack[ stack_size++ ] = node.right;
+		}
+	}
+
 	template<typename _STATE>
 	inline typename TObject<_STATE>::frame_type TObject<_STATE>::get_shape_frame( index_t shape_index ) const {
 		return m_shapes[ shape_index ].get_bounding_box();
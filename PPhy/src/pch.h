@@ -4,4 +4,4 @@
 #include <string>
 #include <chrono>
 #include <array>
-#include <vector>
\ No newline at end of file
+#include <vector>
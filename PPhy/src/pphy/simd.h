@@ -0,0 +1,324 @@
+#pragma once
+// batched overlap kernels over 'SimdWidth' lanes stored as structure of arrays
+
+#include "base.h"
+#include <stddef.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if !defined(PPHY_HIPREC) && defined(__AVX2__)
+#define PPHY_SIMD_AVX2
+#include <immintrin.h>
+#elif !defined(PPHY_HIPREC) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define PPHY_SIMD_SSE
+#include <emmintrin.h>
+#endif
+
+namespace pphy
+{
+	namespace simd
+	{
+#if defined(PPHY_SIMD_AVX2)
+		constexpr size_t SimdWidth = 8;
+#else
+		// the scalar fallback keeps the sse lane count so the callers' chunking stays the same
+		constexpr size_t SimdWidth = 4;
+#endif
+
+		/// @brief tests the frame [frame_begin, frame_end] against the frames at [first, first + SimdWidth)
+		/// @param begins 'DIM' arrays holding the begin point of every frame per axis
+		/// @param ends 'DIM' arrays holding the end point of every frame per axis
+		/// @returns a bitmask with bit 'i' set if frame 'first + i' overlaps
+		/// @note every array must be readable up to 'first + SimdWidth'
+		template <size_t DIM>
+		inline uint32_t overlap_mask( const real_t *const *begins, const real_t *const *ends, size_t first,
+																	const real_t *frame_begin, const real_t *frame_end ) {
+#if defined(PPHY_SIMD_AVX2)
+			__m256 result = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+			for (size_t axis = 0; axis < DIM; axis++)
+			{
+				const __m256 begin = _mm256_loadu_ps( begins[ axis ] + first );
+				const __m256 end = _mm256_loadu_ps( ends[ axis ] + first );
+				result = _mm256_and_ps( result, _mm256_cmp_ps( begin, _mm256_set1_ps( frame_end[ axis ] ), _CMP_LE_OQ ) );
+				result = _mm256_and_ps( result, _mm256_cmp_ps( end, _mm256_set1_ps( frame_begin[ axis ] ), _CMP_GE_OQ ) );
+			}
+			return static_cast<uint32_t>(_mm256_movemask_ps( result ));
+#elif defined(PPHY_SIMD_SSE)
+			__m128 result = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+			for (size_t axis = 0; axis < DIM; axis++)
+			{
+				const __m128 begin = _mm_loadu_ps( begins[ axis ] + first );
+				const __m128 end = _mm_loadu_ps( ends[ axis ] + first );
+				result = _mm_and_ps( result, _mm_cmple_ps( begin, _mm_set1_ps( frame_end[ axis ] ) ) );
+				result = _mm_and_ps( result, _mm_cmpge_ps( end, _mm_set1_ps( frame_begin[ axis ] ) ) );
+			}
+			return static_cast<uint32_t>(_mm_movemask_ps( result ));
+#else
+			uint32_t mask = 0;
+			for (size_t lane = 0; lane < SimdWidth; lane++)
+			{
+				bool overlaps = true;
+				for (size_t axis = 0; axis < DIM; axis++)
+				{
+					overlaps = overlaps
+						&& begins[ axis ][ first + lane ] <= frame_end[ axis ]
+						&& ends[ axis ][ first + lane ] >= frame_begin[ axis ];
+				}
+				mask |= static_cast<uint32_t>(overlaps) << lane;
+			}
+			return mask;
+#endif
+		}
+
+		/// @brief tests the circles 'a' against the circles 'b' lane by lane, for the lanes at [first, first + SimdWidth)
+		/// @returns a bitmask with bit 'i' set if the circles of lane 'first + i' overlap
+		/// @note compares squared distances, every array must be readable up to 'first + SimdWidth'
+		inline uint32_t circle_overlap_mask( const real_t *a_x, const real_t *a_y, const real_t *a_radius,
+																				 const real_t *b_x, const real_t *b_y, const real_t *b_radius, size_t first ) {
+#if defined(PPHY_SIMD_AVX2)
+			const __m256 dx = _mm256_sub_ps( _mm256_loadu_ps( b_x + first ), _mm256_loadu_ps( a_x + first ) );
+			const __m256 dy = _mm256_sub_ps( _mm256_loadu_ps( b_y + first ), _mm256_loadu_ps( a_y + first ) );
+			const __m256 radii = _mm256_add_ps( _mm256_loadu_ps( a_radius + first ), _mm256_loadu_ps( b_radius + first ) );
+			const __m256 distance = _mm256_add_ps( _mm256_mul_ps( dx, dx ), _mm256_mul_ps( dy, dy ) );
+			return static_cast<uint32_t>(_mm256_movemask_ps( _mm256_cmp_ps( distance, _mm256_mul_ps( radii, radii ), _CMP_LT_OQ ) ));
+#elif defined(PPHY_SIMD_SSE)
+			const __m128 dx = _mm_sub_ps( _mm_loadu_ps( b_x + first ), _mm_loadu_ps( a_x + first ) );
+			const __m128 dy = _mm_sub_ps( _mm_loadu_ps( b_y + first ), _mm_loadu_ps( a_y + first ) );
+			const __m128 radii = _mm_add_ps( _mm_loadu_ps( a_radius + first ), _mm_loadu_ps( b_radius + first ) );
+			const __m128 distance = _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) );
+			return static_cast<uint32_t>(_mm_movemask_ps( _mm_cmplt_ps( distance, _mm_mul_ps( radii, radii ) ) ));
+#else
+			uint32_t mask = 0;
+			for (size_t lane = 0; lane < SimdWidth; lane++)
+			{
+				const real_t dx = b_x[ first + lane ] - a_x[ first + lane ];
+				const real_t dy = b_y[ first + lane ] - a_y[ first + lane ];
+				const real_t radii = a_radius[ first + lane ] + b_radius[ first + lane ];
+				mask |= static_cast<uint32_t>(dx * dx + dy * dy < radii * radii) << lane;
+			}
+			return mask;
+#endif
+		}
+
+		/// @brief 'SimdWidth' lanes of real_t, what the wide contact solver computes with
+		/// @note comparisons give a lane mask that only 'select' reads
+		struct Wide
+		{
+#if defined(PPHY_SIMD_AVX2)
+			__m256 value;
+#elif defined(PPHY_SIMD_SSE)
+			__m128 value;
+#else
+			real_t value[ SimdWidth ];
+#endif
+		};
+
+#if defined(PPHY_SIMD_AVX2) || defined(PPHY_SIMD_SSE)
+		// the same operation on every lane, one intrinsic per instruction set
+#if defined(PPHY_SIMD_AVX2)
+#define PPHY_WIDE_OP( name, avx, sse ) inline Wide name( const Wide &a, const Wide &b ) { return { avx( a.value, b.value ) }; }
+#else
+#define PPHY_WIDE_OP( name, avx, sse ) inline Wide name( const Wide &a, const Wide &b ) { return { sse( a.value, b.value ) }; }
+#endif
+		PPHY_WIDE_OP( operator+, _mm256_add_ps, _mm_add_ps )
+		PPHY_WIDE_OP( operator-, _mm256_sub_ps, _mm_sub_ps )
+		PPHY_WIDE_OP( operator*, _mm256_mul_ps, _mm_mul_ps )
+		PPHY_WIDE_OP( operator/, _mm256_div_ps, _mm_div_ps )
+		PPHY_WIDE_OP( max, _mm256_max_ps, _mm_max_ps )
+		PPHY_WIDE_OP( min, _mm256_min_ps, _mm_min_ps )
+#undef PPHY_WIDE_OP
+#else
+		// the scalar fallback runs every operation lane by lane
+#define PPHY_WIDE_OP( name, expression ) \
+		inline Wide name( const Wide &a, const Wide &b ) { \
+			Wide result; \
+			for (size_t lane = 0; lane < SimdWidth; lane++) \
+			{ \
+				const real_t x = a.value[ lane ]; \
+				const real_t y = b.value[ lane ]; \
+				result.value[ lane ] = expression; \
+			} \
+			return result; \
+		}
+		PPHY_WIDE_OP( operator+, x + y )
+		PPHY_WIDE_OP( operator-, x - y )
+		PPHY_WIDE_OP( operator*, x * y )
+		PPHY_WIDE_OP( operator/, x / y )
+		PPHY_WIDE_OP( max, x > y ? x : y )
+		PPHY_WIDE_OP( min, x < y ? x : y )
+#undef PPHY_WIDE_OP
+#endif
+
+		inline Wide load( const real_t *source ) {
+#if defined(PPHY_SIMD_AVX2)
+			return { _mm256_loadu_ps( source ) };
+#elif defined(PPHY_SIMD_SSE)
+			return { _mm_loadu_ps( source ) };
+#else
+			Wide result;
+			for (size_t lane = 0; lane < SimdWidth; lane++)
+			{
+				result.value[ lane ] = source[ lane ];
+			}
+			return result;
+#endif
+		}
+
+		inline void store( real_t *destination, const Wide &wide ) {
+#if defined(PPHY_SIMD_AVX2)
+			_mm256_storeu_ps( destination, wide.value );
+#elif defined(PPHY_SIMD_SSE)
+			_mm_storeu_ps( destination, wide.value );
+#else
+			for (size_t lane = 0; lane < SimdWidth; lane++)
+			{
+				destination[ lane ] = wide.value[ lane ];
+			}
+#endif
+		}
+
+		inline Wide splat( real_t value ) {
+#if defined(PPHY_SIMD_AVX2)
+			return { _mm256_set1_ps( value ) };
+#elif defined(PPHY_SIMD_SSE)
+			return { _mm_set1_ps( value ) };
+#else
+			Wide result;
+			for (size_t lane = 0; lane < SimdWidth; lane++)
+			{
+				result.value[ lane ] = value;
+			}
+			return result;
+#endif
+		}
+
+		/// @returns lane 'i' read from 'base[ offsets[ i ] ]'
+		inline Wide gather( const real_t *base, const int32_t *offsets ) {
+#if defined(PPHY_SIMD_AVX2)
+			return { _mm256_i32gather_ps( base, _mm256_loadu_si256( reinterpret_cast<const __m256i *>(offsets) ), 4 ) };
+#elif defined(PPHY_SIMD_SSE)
+			return { _mm_setr_ps( base[ offsets[ 0 ] ], base[ offsets[ 1 ] ], base[ offsets[ 2 ] ], base[ offsets[ 3 ] ] ) };
+#else
+			Wide result;
+			for (size_t lane = 0; lane < SimdWidth; lane++)
+			{
+				result.value[ lane ] = base[ offsets[ lane ] ];
+			}
+			return result;
+#endif
+		}
+
+		/// @brief writes lane 'i' to 'base[ offsets[ i ] ]', later lanes win if two share an offset
+		inline void scatter( real_t *base, const int32_t *offsets, const Wide &wide ) {
+			real_t lanes[ SimdWidth ];
+			store( lanes, wide );
+			for (size_t lane = 0; lane < SimdWidth; lane++)
+			{
+				base[ offsets[ lane ] ] = lanes[ lane ];
+			}
+		}
+
+		inline Wide sqrt( const Wide &wide ) {
+#if defined(PPHY_SIMD_AVX2)
+			return { _mm256_sqrt_ps( wide.value ) };
+#elif defined(PPHY_SIMD_SSE)
+			return { _mm_sqrt_ps( wide.value ) };
+#else
+			Wide result;
+			for (size_t lane = 0; lane < SimdWidth; lane++)
+			{
+				result.value[ lane ] = std::sqrt( wide.value[ lane ] );
+			}
+			return result;
+#endif
+		}
+
+		/// @returns all bits set in the lanes where 'a' is greater than 'b'
+		inline Wide greater( const Wide &a, const Wide &b ) {
+#if defined(PPHY_SIMD_AVX2)
+			return { _mm256_cmp_ps( a.value, b.value, _CMP_GT_OQ ) };
+#elif defined(PPHY_SIMD_SSE)
+			return { _mm_cmpgt_ps( a.value, b.value ) };
+#else
+			// the fallback keeps the mask as ones and zeros
+			Wide result;
+			for (size_t lane = 0; lane < SimdWidth; lane++)
+			{
+				result.value[ lane ] = a.value[ lane ] > b.value[ lane ] ? real_t( 1 ) : real_t( 0 );
+			}
+			return result;
+#endif
+		}
+
+		/// @returns 'a' in the lanes set in 'mask' (from 'greater'), 'b' in the rest
+		inline Wide select( const Wide &mask, const Wide &a, const Wide &b ) {
+#if defined(PPHY_SIMD_AVX2)
+			return { _mm256_blendv_ps( b.value, a.value, mask.value ) };
+#elif defined(PPHY_SIMD_SSE)
+			return { _mm_or_ps( _mm_and_ps( mask.value, a.value ), _mm_andnot_ps( mask.value, b.value ) ) };
+#else
+			Wide result;
+			for (size_t lane = 0; lane < SimdWidth; lane++)
+			{
+				result.value[ lane ] = mask.value[ lane ] != 0 ? a.value[ lane ] : b.value[ lane ];
+			}
+			return result;
+#endif
+		}
+
+		/// @returns the largest lane
+		inline real_t reduce_max( const Wide &wide ) {
+			real_t lanes[ SimdWidth ];
+			store( lanes, wide );
+			real_t result = lanes[ 0 ];
+			for (size_t lane = 1; lane < SimdWidth; lane++)
+			{
+				result = lanes[ lane ] > result ? lanes[ lane ] : result;
+			}
+			return result;
+		}
+
+		/// @returns the index of the lowest set bit, 'mask' can't be zero
+		inline uint32_t lowest_bit( uint32_t mask ) {
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward( &index, mask );
+			return static_cast<uint32_t>(index);
+#elif defined(__GNUC__)
+			return static_cast<uint32_t>(__builtin_ctz( mask ));
+#else
+			uint32_t index = 0;
+			while (!(mask & 1u))
+			{
+				mask >>= 1;
+				index++;
+			}
+			return index;
+#endif
+		}
+
+		/// @returns the number of leading zero bits, 32 for zero
+		inline uint32_t leading_zeros( uint32_t value ) {
+			if (value == 0)
+				return 32;
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanReverse( &index, value );
+			return 31 - static_cast<uint32_t>(index);
+#elif defined(__GNUC__)
+			return static_cast<uint32_t>(__builtin_clz( value ));
+#else
+			uint32_t count = 0;
+			while (!(value & 0x80000000u))
+			{
+				value <<= 1;
+				count++;
+			}
+			return count;
+#endif
+		}
+
+	}
+}
@@ -114,7 +114,7 @@ namespace pphy
 
 		inline constexpr value_type dot(const this_type &other) const
 		{
-			return (this->x * other.x) - (this->y * other.y);
+			return (this->x * other.x) + (this->y * other.y);
 		}
 
 		inline void normalize()
@@ -1,9 +1,85 @@
 #include <iostream>
+#include <cstdlib>
+#include <new>
+#include <random>
 #include <PPhy.h>
 
+// counts every allocation, steady steps aren't supposed to make any
+static size_t g_allocations = 0;
+
+void *operator new( size_t size ) {
+	g_allocations++;
+	if (void *memory = std::malloc( size ? size : 1 ))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete( void *memory ) noexcept {
+	std::free( memory );
+}
+
+void operator delete( void *memory, size_t ) noexcept {
+	std::free( memory );
+}
+
+// 2000 resting circles close enough to pair into islands of every size, the allocations of 30 steps once they settled
+template <typename _SPACE>
+static size_t count_steady_allocations() {
+	_SPACE space{};
+	std::mt19937 random{ 7 };
+	std::uniform_real_distribution<real_t> coordinate{ 0, 60 };
+	std::vector<pphy::Vector2> positions;
+	while (positions.size() < 2000)
+	{
+		const pphy::Vector2 position{ coordinate( random ), coordinate( random ) };
+		bool free = true;
+		for (const pphy::Vector2 &other : positions)
+		{
+			free = free && position.distance( other ) >= real_t( 1.01 );
+		}
+		if (!free)
+			continue;
+
+		positions.push_back( position );
+		pphy::Object2D object{ pphy::ObjectType::Rigid };
+		object.set_position( position );
+		pphy::Shape2D shape{ pphy::ShapeType2D::Circle };
+		shape.get_circle() = { { 0, 0 }, real_t( 0.5 ) };
+		object.add_shape( shape );
+		space.add_object( object );
+	}
+
+	for (int step = 0; step < 10; step++)
+	{
+		space.update( 1. / 60. );
+	}
+
+	const size_t before = g_allocations;
+	for (int step = 0; step < 30; step++)
+	{
+		space.update( 1. / 60. );
+	}
+	return g_allocations - before;
+}
+
 int main() {
 	pphy::Space2D space{};
 	pphy::Object2D object{ pphy::ObjectType::Static };
 	space.add_object( object );
 	space.update( 1. / 60. );
+
+	const size_t allocations[] = {
+		count_steady_allocations<pphy::Space2D>(),
+		count_steady_allocations<pphy::SweepSpace2D>(),
+		count_steady_allocations<pphy::TreeSpace2D>(),
+		count_steady_allocations<pphy::HashGridSpace2D>(),
+	};
+	std::cout << "steady step allocations: bounds " << allocations[ 0 ] << ", sweep " << allocations[ 1 ]
+		<< ", tree " << allocations[ 2 ] << ", hash grid " << allocations[ 3 ] << '\n';
+
+	for (const size_t count : allocations)
+	{
+		if (count > 0)
+			return 1;
+	}
 }